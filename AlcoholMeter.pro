@@ -1,4 +1,4 @@
-QT += core gui bluetooth network
+QT += core gui bluetooth network concurrent
 
 CONFIG += c++17 console
 CONFIG -= app_bundle
@@ -7,19 +7,67 @@ CONFIG -= app_bundle
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
-LIBS += -lwiringPi
+LIBS += -lwiringPi -lgpiod
+
+INCLUDEPATH += common
 
 SOURCES += \
+    common/loopbacktransport.cpp \
+    ads1115adcsource.cpp \
     alcoholmeter.cpp \
+    calibrationstore.cpp \
+    decimator.cpp \
+    faultdetector.cpp \
     gattserver.cpp \
+    hampelfilter.cpp \
+    gpiodeventsource.cpp \
+    i2cbus.cpp \
     kalmanfilter.cpp \
-    main.cpp
+    logger.cpp \
+    main.cpp \
+    measurementlog.cpp \
+    measurementpipeline.cpp \
+    metrics.cpp \
+    metricsserver.cpp \
+    parameterregistry.cpp \
+    sessionstore.cpp \
+    slidingmedian.cpp \
+    startuptracker.cpp \
+    telemetryserver.cpp \
+    wiringpiadcsource.cpp
 
 HEADERS += \
+    common/logrecord.h \
+    common/loopbacktransport.h \
+    common/message.h \
+    common/metricssummary.h \
+    common/parametervalue.h \
+    common/sensorfault.h \
+    common/protocol.h \
+    common/transport.h \
+    adcsource.h \
+    ads1115adcsource.h \
     alcoholmeter.h \
+    calibrationstore.h \
+    decimator.h \
+    faultdetector.h \
     gattserver.h \
+    hampelfilter.h \
+    gpiodeventsource.h \
+    gpioeventsource.h \
+    i2cbus.h \
     kalmanfilter.h \
-    message.h
+    logger.h \
+    measurementlog.h \
+    measurementpipeline.h \
+    metrics.h \
+    metricsserver.h \
+    parameterregistry.h \
+    sessionstore.h \
+    slidingmedian.h \
+    startuptracker.h \
+    telemetryserver.h \
+    wiringpiadcsource.h
 
 # Default rules for deployment.
 qnx: target.path = /tmp/$${TARGET}/bin
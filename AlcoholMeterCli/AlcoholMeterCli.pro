@@ -0,0 +1,31 @@
+# Headless soak test client, reuses the GUI client's transports:
+#   qmake AlcoholMeterCli/AlcoholMeterCli.pro && make && ./AlcoholMeterCli --help
+QT = core bluetooth network
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+INCLUDEPATH += .. ../AlcoholMeterClient ../common
+
+SOURCES += \
+    ../AlcoholMeterClient/bluetoothclient.cpp \
+    ../AlcoholMeterClient/deviceinfo.cpp \
+    ../AlcoholMeterClient/tcpclient.cpp \
+    ../common/requesttable.cpp \
+    ../metrics.cpp \
+    main.cpp \
+    soaktest.cpp
+
+HEADERS += \
+    ../AlcoholMeterClient/bluetoothclient.h \
+    ../AlcoholMeterClient/deviceinfo.h \
+    ../AlcoholMeterClient/tcpclient.h \
+    ../common/message.h \
+    ../common/metricssummary.h \
+    ../common/parametervalue.h \
+    ../common/sensorfault.h \
+    ../common/protocol.h \
+    ../common/requesttable.h \
+    ../common/transport.h \
+    ../metrics.h \
+    soaktest.h
@@ -0,0 +1,116 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QHash>
+#include <QTextStream>
+#include <QTimer>
+#include <csignal>
+#include "bluetoothclient.h"
+#include "protocol.h"
+#include "soaktest.h"
+#include "tcpclient.h"
+
+// Headless client for soak tests of the device daemon, e.g. overnight:
+//   AlcoholMeterCli --host raspberrypi --rate 50 --cycle 120 --calibrate-every 10 --duration 43200
+// Without --host the first meter found over BLE is used, like the GUI does.
+
+namespace {
+
+volatile std::sig_atomic_t interrupted = 0;
+
+void onSignal(int)
+{
+    interrupted = 1;
+}
+
+bool parseCommands(const QString &value, QList<uint8_t> &commands)
+{
+    static const QHash<QString, uint8_t> names = {
+        {"calcval0", mCalcVal0}, {"calcval1", mCalcVal1}, {"calcval2", mCalcVal2},
+        {"calcval3", mCalcVal3}, {"r0", mR0}
+    };
+    const QStringList parts = value.split(',', Qt::SkipEmptyParts);
+    for (const QString &part : parts) {
+        auto it = names.constFind(part.trimmed().toLower());
+        if (it == names.constEnd())
+            return false;
+        commands.append(it.value());
+    }
+    return !commands.isEmpty();
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+    QCoreApplication::setOrganizationName("tbiliyor");
+    QCoreApplication::setApplicationName("AlcoholMeter");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Command line client and load generator for the AlcoholMeter daemon");
+    parser.addHelpOption();
+    QCommandLineOption hostOption("host", "Use the device's TCP endpoint instead of BLE.", "host[:port]");
+    QCommandLineOption durationOption("duration", "Seconds to run, 0 until interrupted.", "seconds", "0");
+    QCommandLineOption rateOption("rate", "Read commands per second.", "rate", "20");
+    QCommandLineOption commandsOption("commands", "Reads to send round robin.", "list",
+                                      "calcval0,calcval1,calcval2,calcval3,r0");
+    QCommandLineOption cycleOption("cycle", "Toggle measurements every N seconds, 0 never.", "seconds", "0");
+    QCommandLineOption calibrateOption("calibrate-every", "Calibrate after every N cycles, 0 never.", "cycles", "0");
+    QCommandLineOption timeoutOption("timeout", "Milliseconds until a read counts as lost.", "ms", "2000");
+    QCommandLineOption reportOption("report", "Seconds between interim reports, 0 only at the end.", "seconds", "60");
+    parser.addOptions({hostOption, durationOption, rateOption, commandsOption, cycleOption,
+                       calibrateOption, timeoutOption, reportOption});
+    parser.process(a);
+
+    QTextStream out(stdout);
+    QTextStream err(stderr);
+
+    SoakOptions options;
+    options.duration = parser.value(durationOption).toInt();
+    options.rate = parser.value(rateOption).toInt();
+    options.cycle = parser.value(cycleOption).toInt();
+    options.calibrateEvery = parser.value(calibrateOption).toInt();
+    options.timeout = parser.value(timeoutOption).toInt();
+    options.report = parser.value(reportOption).toInt();
+    if (!parseCommands(parser.value(commandsOption), options.commands)) {
+        err << "Invalid --commands, use calcval0..3 and r0" << Qt::endl;
+        return 2;
+    }
+    if (options.rate <= 0 || options.timeout <= 0) {
+        err << "--rate and --timeout must be positive" << Qt::endl;
+        return 2;
+    }
+
+    Transport *transport = nullptr;
+    if (parser.isSet(hostOption)) {
+        const QStringList parts = parser.value(hostOption).split(':');
+        quint16 port = parts.size() > 1 ? parts.at(1).toUShort() : 0;
+        transport = new TcpClient(parts.at(0), port ? port : 5050, &a);
+    } else {
+        auto *client = new BluetoothClient();
+        client->setParent(&a);
+        QObject::connect(client, &BluetoothClient::statusChanged, &a, [&out](const QString &status) {
+            out << status << Qt::endl;
+        });
+        transport = client;
+    }
+
+    SoakTest soak(transport, options, out);
+    QObject::connect(&soak, &SoakTest::finished, &a, &QCoreApplication::quit);
+
+    // Ctrl+C and SIGTERM end the run with a final report
+    std::signal(SIGINT, onSignal);
+    std::signal(SIGTERM, onSignal);
+    QTimer signalTimer;
+    QObject::connect(&signalTimer, &QTimer::timeout, &a, [&a]() {
+        if (interrupted)
+            a.quit();
+    });
+    signalTimer.start(200);
+
+    soak.start();
+    a.exec();
+    soak.stop();
+    soak.printReport();
+    return soak.succeeded() ? 0 : 1;
+}
@@ -0,0 +1,168 @@
+#include "soaktest.h"
+#include "protocol.h"
+
+SoakTest::SoakTest(Transport *transport, const SoakOptions &options, QTextStream &out, QObject *parent)
+    : QObject(parent)
+    , m_transport(transport)
+    , m_options(options)
+    , m_out(out)
+{
+    m_requests = new RequestTable(m_transport, this);
+    for (uint8_t command : std::as_const(m_options.commands)) {
+        m_stats[command];
+    }
+
+    m_tickTimer = new QTimer(this);
+    m_tickTimer->setTimerType(Qt::PreciseTimer);
+    m_tickTimer->setInterval(TICK_INTERVAL);
+    connect(m_tickTimer, &QTimer::timeout, this, &SoakTest::tick);
+
+    m_cycleTimer = new QTimer(this);
+    m_cycleTimer->setInterval(m_options.cycle * 1000);
+    connect(m_cycleTimer, &QTimer::timeout, this, &SoakTest::toggleMeasurement);
+
+    m_reportTimer = new QTimer(this);
+    m_reportTimer->setInterval(m_options.report * 1000);
+    connect(m_reportTimer, &QTimer::timeout, this, &SoakTest::printReport);
+
+    connect(m_transport, &Transport::connectionState, this, &SoakTest::onConnectionState);
+    connect(m_transport, &Transport::sendInfo, this, [this](const QString &info) {
+        m_out << info << Qt::endl;
+    });
+}
+
+void SoakTest::start()
+{
+    m_clock.start();
+    if (m_options.duration > 0)
+        QTimer::singleShot(m_options.duration * 1000, this, &SoakTest::finished);
+    if (m_options.report > 0)
+        m_reportTimer->start();
+    m_transport->start();
+}
+
+void SoakTest::stop()
+{
+    m_tickTimer->stop();
+    m_cycleTimer->stop();
+    m_reportTimer->stop();
+    if (m_measuring && m_transport->isConnected())
+        m_transport->writeValue(Protocol::encode<mStop, mWrite>(0));
+    m_measuring = false;
+    m_transport->stop();
+}
+
+bool SoakTest::succeeded() const
+{
+    for (const auto &entry : m_stats) {
+        if (entry.second.replies > 0)
+            return true;
+    }
+    return false;
+}
+
+void SoakTest::onConnectionState(bool connected)
+{
+    if (connected) {
+        m_out << "Connected, " << m_options.rate << " reads/s" << Qt::endl;
+        m_lastTick = m_clock.nsecsElapsed();
+        m_credit = 0.0;
+        m_tickTimer->start();
+        if (m_options.cycle > 0)
+            m_cycleTimer->start();
+        return;
+    }
+
+    // Reads in flight are failed by the request table
+    m_disconnects++;
+    m_tickTimer->stop();
+    m_cycleTimer->stop();
+    m_measuring = false;
+    m_out << "Disconnected" << Qt::endl;
+}
+
+void SoakTest::tick()
+{
+    const qint64 now = m_clock.nsecsElapsed();
+    m_credit += m_options.rate * (now - m_lastTick) / 1e9;
+    m_lastTick = now;
+
+    // Never build up more than one tick of backlog after a stall
+    m_credit = qMin(m_credit, qMax(1.0, m_options.rate * TICK_INTERVAL / 1000.0));
+    const int count = m_options.commands.size();
+    while (m_credit >= 1.0) {
+        m_credit -= 1.0;
+        for (int i = 0; i < count; ++i) {
+            const uint8_t command = m_options.commands.at(m_next);
+            m_next = (m_next + 1) % count;
+            if (m_stats[command].pending >= MAX_PENDING)
+                continue;
+            sendRead(command);
+            break;
+        }
+    }
+}
+
+void SoakTest::sendRead(uint8_t command)
+{
+    // Counted before sending, a synchronous transport may answer right away
+    CommandStats &stats = m_stats[command];
+    stats.sent++;
+    stats.pending++;
+
+    const qint64 sent = m_clock.nsecsElapsed();
+    const uint8_t id = m_requests->request(command, QByteArray(),
+        [this, command, sent](RequestTable::Result result, const Protocol::Frame &) {
+            CommandStats &stats = m_stats[command];
+            stats.pending--;
+            if (result == RequestTable::Ok) {
+                stats.replies++;
+                stats.latency.record(m_clock.nsecsElapsed() - sent);
+            } else if (result == RequestTable::Disconnected) {
+                stats.disconnected++;
+            } else {
+                stats.timeouts++;
+            }
+        }, m_options.timeout);
+
+    if (!id) {
+        stats.sent--;
+        stats.pending--;
+    }
+}
+
+void SoakTest::toggleMeasurement()
+{
+    m_measuring = !m_measuring;
+    if (m_measuring) {
+        m_transport->writeValue(Protocol::encode<mStart, mWrite>(0));
+        return;
+    }
+
+    m_transport->writeValue(Protocol::encode<mStop, mWrite>(0));
+    m_cycles++;
+    if (m_options.calibrateEvery > 0 && m_cycles % m_options.calibrateEvery == 0) {
+        m_transport->writeValue(Protocol::encode<mCalibrate, mWrite>(0));
+        m_calibrations++;
+    }
+}
+
+void SoakTest::printReport()
+{
+    const double seconds = m_clock.elapsed() / 1000.0;
+    m_out << QString("--- %1 s, %2 cycles, %3 calibrations, %4 disconnects, %5 stray replies\n")
+                 .arg(seconds, 0, 'f', 0).arg(m_cycles).arg(m_calibrations).arg(m_disconnects)
+                 .arg(m_requests->strayReplies());
+    m_out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n").arg("command", -10).arg("sent", 9).arg("replies", 9)
+                 .arg("timeouts", 9).arg("lost", 9).arg("p50 ms", 9).arg("p90 ms", 9).arg("p99 ms", 9).arg("max ms", 9);
+
+    for (const auto &entry : m_stats) {
+        const CommandStats &stats = entry.second;
+        auto ms = [](quint64 ns) { return QString::number(ns / 1e6, 'f', 2); };
+        m_out << QString("%1 %2 %3 %4 %5 %6 %7 %8 %9\n").arg(QString::fromLatin1(Protocol::commandName(entry.first)), -10)
+                     .arg(stats.sent, 9).arg(stats.replies, 9).arg(stats.timeouts, 9).arg(stats.disconnected, 9)
+                     .arg(ms(stats.latency.percentile(50)), 9).arg(ms(stats.latency.percentile(90)), 9)
+                     .arg(ms(stats.latency.percentile(99)), 9).arg(ms(stats.latency.max()), 9);
+    }
+    m_out.flush();
+}
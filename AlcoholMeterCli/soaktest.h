@@ -0,0 +1,83 @@
+#ifndef SOAKTEST_H
+#define SOAKTEST_H
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QTextStream>
+#include <QTimer>
+#include <map>
+#include "metrics.h"
+#include "requesttable.h"
+#include "transport.h"
+
+struct SoakOptions {
+    int duration = 0;               // Seconds, 0 runs until interrupted
+    int rate = 20;                  // Read commands per second over all kinds
+    QList<uint8_t> commands;        // Read commands to send round robin
+    int cycle = 0;                  // Seconds between start and stop, 0 never measures
+    int calibrateEvery = 0;         // Calibrate after every N measurement cycles, 0 never
+    int timeout = 2000;             // Milliseconds until a read counts as lost
+    int report = 60;                // Seconds between interim reports, 0 only at the end
+};
+
+// Drives a device through a Transport: reads at a fixed rate, optional
+// start/stop/calibrate cycles, and round-trip latency per command.
+//
+// Reads are tagged through a RequestTable, so any number of them can be in
+// flight and replies are never mistaken for the measurement telemetry.
+class SoakTest : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int TICK_INTERVAL = 5;         // ms, granularity of the send rate
+    static constexpr int MAX_PENDING = 48;          // Per command, five kinds stay below the 255 ids
+
+    SoakTest(Transport *transport, const SoakOptions &options, QTextStream &out, QObject *parent = nullptr);
+
+    void start();
+    void stop();
+    void printReport();
+
+    // True if at least one read was answered
+    bool succeeded() const;
+
+signals:
+    void finished();
+
+private slots:
+    void onConnectionState(bool connected);
+    void tick();
+    void toggleMeasurement();
+
+private:
+    struct CommandStats {
+        quint64 sent = 0;
+        quint64 replies = 0;
+        quint64 timeouts = 0;
+        int pending = 0;
+        quint64 disconnected = 0;   // Lost with the link
+        LatencyHistogram latency;
+    };
+
+    void sendRead(uint8_t command);
+
+    Transport *m_transport;
+    RequestTable *m_requests;
+    SoakOptions m_options;
+    QTextStream &m_out;
+    std::map<uint8_t, CommandStats> m_stats;
+    QElapsedTimer m_clock;
+    QTimer *m_tickTimer;
+    QTimer *m_cycleTimer;
+    QTimer *m_reportTimer;
+    qint64 m_lastTick = 0;
+    double m_credit = 0.0;          // Reads owed to the configured rate
+    int m_next = 0;                 // Round robin position in m_options.commands
+    bool m_measuring{false};
+    quint64 m_cycles = 0;
+    quint64 m_calibrations = 0;
+    quint64 m_disconnects = 0;
+};
+
+#endif // SOAKTEST_H
@@ -1,24 +1,48 @@
-QT       += core gui bluetooth
+QT       += core gui bluetooth network
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
 CONFIG += c++17
 
+INCLUDEPATH += $$PWD/../common
+
 # You can make your code fail to compile if it uses deprecated APIs.
 # In order to do so, uncomment the following line.
 #DEFINES += QT_DISABLE_DEPRECATED_BEFORE=0x060000    # disables all the APIs deprecated before Qt 6.0.0
 
 SOURCES += \
     bluetoothclient.cpp \
+    dashboard.cpp \
+    decimatingbuffer.cpp \
+    deviceconnection.cpp \
     deviceinfo.cpp \
+    devicepool.cpp \
+    framedecoder.cpp \
+    historysync.cpp \
+    livechart.cpp \
     main.cpp \
-    mainwindow.cpp
+    mainwindow.cpp \
+    tcpclient.cpp
 
 HEADERS += \
+    $$PWD/../common/logrecord.h \
+    $$PWD/../common/message.h \
+    $$PWD/../common/metricssummary.h \
+    $$PWD/../common/parametervalue.h \
+    $$PWD/../common/sensorfault.h \
+    $$PWD/../common/protocol.h \
+    $$PWD/../common/transport.h \
     bluetoothclient.h \
+    dashboard.h \
+    decimatingbuffer.h \
+    deviceconnection.h \
     deviceinfo.h \
+    devicepool.h \
+    framedecoder.h \
+    historysync.h \
+    livechart.h \
     mainwindow.h \
-    message.h
+    tcpclient.h
 
 FORMS += \
     mainwindow.ui
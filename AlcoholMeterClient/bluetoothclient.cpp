@@ -1,4 +1,5 @@
 #include "bluetoothclient.h"
+#include <QSettings>
 
 BluetoothClient::BluetoothClient() :
     m_control(nullptr),
@@ -7,7 +8,7 @@ BluetoothClient::BluetoothClient() :
 {
     /* 1 Step: Bluetooth LE Device Discovery */
     m_deviceDiscoveryAgent = new QBluetoothDeviceDiscoveryAgent(this);
-    m_deviceDiscoveryAgent->setLowEnergyDiscoveryTimeout(60000);
+    m_deviceDiscoveryAgent->setLowEnergyDiscoveryTimeout(SCAN_TIMEOUT);
     /* Device Discovery Initialization */
     connect(m_deviceDiscoveryAgent, &QBluetoothDeviceDiscoveryAgent::deviceDiscovered,
             this, &BluetoothClient::addDevice);
@@ -17,6 +18,14 @@ BluetoothClient::BluetoothClient() :
             this, &BluetoothClient::scanFinished);
     connect(m_deviceDiscoveryAgent, &QBluetoothDeviceDiscoveryAgent::canceled,
             this, &BluetoothClient::scanFinished);
+
+    m_directConnectTimer = new QTimer(this);
+    m_directConnectTimer->setSingleShot(true);
+    m_directConnectTimer->setInterval(DIRECT_CONNECT_TIMEOUT);
+    connect(m_directConnectTimer, &QTimer::timeout, this, [this]() {
+        qDebug() << "Direct connect timed out";
+        fallBackToScan();
+    });
 }
 
 BluetoothClient::~BluetoothClient(){
@@ -24,6 +33,30 @@ BluetoothClient::~BluetoothClient(){
         delete current_device;
 }
 
+void BluetoothClient::start()
+{
+    m_running = true;
+    // Skip discovery when we know where the device is
+    if (!connectToCachedDevice())
+        startScan();
+}
+
+void BluetoothClient::stop()
+{
+    m_running = false;
+    m_directConnect = false;
+    m_directConnectTimer->stop();
+    if (m_deviceDiscoveryAgent->isActive())
+        m_deviceDiscoveryAgent->stop();
+    if (m_control)
+        disconnectFromDevice();
+}
+
+void BluetoothClient::writeValue(const QByteArray &value)
+{
+    writeData(value);
+}
+
 void BluetoothClient::getDeviceList(QList<QString> &qlDevices){
 
     if(m_state == bluetoothleState::ScanFinished && current_device)
@@ -47,6 +80,7 @@ void BluetoothClient::addDevice(const QBluetoothDeviceInfo &device)
 
         if(device.name().startsWith("Alcohol"))
         {
+            delete current_device;
             current_device = new DeviceInfo(device);
             m_deviceDiscoveryAgent->stop();
             emit m_deviceDiscoveryAgent->finished();
@@ -86,20 +120,98 @@ void BluetoothClient::deviceScanError(QBluetoothDeviceDiscoveryAgent::Error erro
 void BluetoothClient::startScan(){
 
     setState(Scanning);
+    delete current_device;
     current_device = nullptr;
-    m_deviceDiscoveryAgent->start();
+    m_deviceDiscoveryAgent->start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
     qDebug() << "startScan";
 }
 
-void BluetoothClient::startConnect(int i){
+bool BluetoothClient::connectToCachedDevice()
+{
+    QSettings settings;
+    settings.beginGroup("ble");
+    const QString name = settings.value("name").toString();
+#if defined(Q_OS_DARWIN)
+    // Core Bluetooth hides addresses behind a per-phone device UUID
+    const QBluetoothUuid uuid(settings.value("uuid").toString());
+    if (uuid.isNull())
+        return false;
+    QBluetoothDeviceInfo device(uuid, name, 0);
+#else
+    const QBluetoothAddress address(settings.value("address").toString());
+    if (address.isNull())
+        return false;
+    QBluetoothDeviceInfo device(address, name, 0);
+#endif
+    device.setCoreConfigurations(QBluetoothDeviceInfo::LowEnergyCoreConfiguration);
+
+    current_gatt = QBluetoothUuid(settings.value("service", SCANPARAMETERSUUID).toString());
+    m_cachedRx = QBluetoothUuid(settings.value("rx").toString());
+    m_cachedTx = QBluetoothUuid(settings.value("tx").toString());
+
+    delete current_device;
+    current_device = new DeviceInfo(device);
+
+    qDebug() << "Connecting directly to" << name << current_device->getAddress();
+    m_directConnect = true;
+    m_directConnectTimer->start();
+    startConnect(0);
+    return true;
+}
 
-    m_qvMeasurements.clear();
+void BluetoothClient::saveDevice()
+{
+    if (!current_device)
+        return;
+
+    QSettings settings;
+    settings.beginGroup("ble");
+    settings.setValue("name", current_device->getName());
+#if defined(Q_OS_DARWIN)
+    settings.setValue("uuid", current_device->getDevice().deviceUuid().toString());
+#else
+    settings.setValue("address", current_device->getDevice().address().toString());
+#endif
+    settings.setValue("service", current_gatt.toString());
+    settings.setValue("rx", m_readCharacteristic.uuid().toString());
+    settings.setValue("tx", m_writeCharacteristic.uuid().toString());
+}
+
+void BluetoothClient::fallBackToScan()
+{
+    if (!m_directConnect)
+        return;
+
+    m_directConnect = false;
+    m_directConnectTimer->stop();
+    resetController();
+    if (!m_running)
+        return;
+
+    qDebug() << "Cached device not reachable, scanning";
+    startScan();
+}
+
+void BluetoothClient::resetController()
+{
+    delete m_service;
+    m_service = nullptr;
+    m_readCharacteristic = QLowEnergyCharacteristic();
+    m_writeCharacteristic = QLowEnergyCharacteristic();
 
     if (m_control) {
+        m_control->disconnect(this);
         m_control->disconnectFromDevice();
-        delete m_control;
-        m_control = 0;
+        m_control->deleteLater();
+        m_control = nullptr;
     }
+}
+
+void BluetoothClient::startConnect(int i){
+
+    m_qvMeasurements.clear();
+    m_bFoundUARTService = false;
+    resetController();
 
     /* 2 Step: QLowEnergyController */
     m_control = QLowEnergyController::createCentral(current_device->getDevice(), this);
@@ -129,21 +241,33 @@ void BluetoothClient::serviceDiscovered(const QBluetoothUuid &gatt)
     {
         m_bFoundUARTService =true;
         current_gatt = gatt;
+
+        // The remembered service is all we need, no need to wait for the full discovery
+        if (m_directConnect)
+            setupService();
     }
 }
 
 void BluetoothClient::serviceScanDone()
 {
-    delete m_service;
-    m_service=0;
+    if (m_service)
+        return;
+    setupService();
+}
 
+void BluetoothClient::setupService()
+{
     if(m_bFoundUARTService)
     {
         m_service = m_control->createServiceObject(current_gatt, this);
     }
 
     if(!m_service)
-    {       
+    {
+        if (m_directConnect) {
+            fallBackToScan();
+            return;
+        }
         disconnectFromDevice();
         setState(DisConnected);
         return;
@@ -161,22 +285,37 @@ void BluetoothClient::serviceScanDone()
     connect(m_service, SIGNAL(descriptorWritten(QLowEnergyDescriptor,QByteArray)),
             this, SLOT(confirmedDescriptorWrite(QLowEnergyDescriptor,QByteArray)));
 
-    m_service->discoverDetails();
+    // Only handles and descriptors are needed, reading every value just costs round trips
+    m_service->discoverDetails(QLowEnergyService::SkipValueDiscovery);
     setState(ServiceFound);
 
 }
 
 void BluetoothClient::disconnectFromDevice()
 {
-    m_control->disconnectFromDevice();
+    if (m_control)
+        m_control->disconnectFromDevice();
 }
 
 void BluetoothClient::deviceDisconnected()
 {
     qDebug() << "deviceDisconnected";
+    if (m_directConnect) {
+        fallBackToScan();
+        return;
+    }
+
+    bool wasReady = (m_state == AcquireData);
     delete m_service;
     m_service = 0;
     setState(DisConnected);
+
+    // Lost a working link, try the fast path again before rescanning
+    if (wasReady && m_running)
+        QTimer::singleShot(RECONNECT_DELAY, this, [this]() {
+            if (m_running && m_state == DisConnected && !connectToCachedDevice())
+                startScan();
+        });
 }
 
 void BluetoothClient::deviceConnected()
@@ -190,6 +329,10 @@ void BluetoothClient::errorOccurred(QLowEnergyController::Error newError)
 {
     auto statusText = QString("Controller Error: %1").arg(newError);
     qDebug() << statusText;
+    if (m_directConnect) {
+        fallBackToScan();
+        return;
+    }
     emit statusChanged(statusText);
 }
 
@@ -202,6 +345,21 @@ void BluetoothClient::controllerError(QLowEnergyController::Error error)
 void BluetoothClient::searchCharacteristic()
 {
     if(m_service){
+        // Characteristics remembered from the last session, when they are still there
+        QLowEnergyCharacteristic cachedTx = m_cachedTx.isNull() ? QLowEnergyCharacteristic() : m_service->characteristic(m_cachedTx);
+        QLowEnergyCharacteristic cachedRx = m_cachedRx.isNull() ? QLowEnergyCharacteristic() : m_service->characteristic(m_cachedRx);
+        if (cachedTx.isValid() && cachedRx.isValid()) {
+            m_writeCharacteristic = cachedTx;
+            m_writeMode = (cachedTx.properties() & QLowEnergyCharacteristic::WriteNoResponse)
+                              ? QLowEnergyService::WriteWithoutResponse : QLowEnergyService::WriteWithResponse;
+            m_readCharacteristic = cachedRx;
+            m_notificationDescRx = cachedRx.descriptor(QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration);
+            if (m_notificationDescRx.isValid()) {
+                m_service->writeDescriptor(m_notificationDescRx, QByteArray::fromHex("0100"));
+                return;
+            }
+        }
+
         foreach (QLowEnergyCharacteristic c, m_service->characteristics())
         {
             if(c.isValid())
@@ -251,11 +409,14 @@ void BluetoothClient::serviceStateChanged(QLowEnergyService::ServiceState s)
 
 void BluetoothClient::updateData(const QLowEnergyCharacteristic &c,const QByteArray &value)
 {
-    emit newData(value);
+    emit dataReceived(value);
 }
 
 void BluetoothClient::confirmedDescriptorWrite(const QLowEnergyDescriptor &d, const QByteArray &value)
 {
+    m_directConnect = false;
+    m_directConnectTimer->stop();
+    saveDevice();
     setState(AcquireData);
 }
 
@@ -273,8 +434,15 @@ void BluetoothClient::setState(BluetoothClient::bluetoothleState newState)
     if (m_state == newState)
         return;
 
+    bool wasReady = (m_state == AcquireData);
     m_state = newState;
     emit changedState(newState);
+
+    // The transport is usable once notifications are enabled
+    if (newState == AcquireData)
+        emit connectionState(true);
+    else if (wasReady)
+        emit connectionState(false);
 }
 
 BluetoothClient::bluetoothleState BluetoothClient::getState() const {
@@ -284,3 +452,14 @@ BluetoothClient::bluetoothleState BluetoothClient::getState() const {
 bool BluetoothClient::isConnected() const {
     return m_state == Connected || m_state == ServiceFound || m_state == AcquireData;
 }
+
+QString BluetoothClient::peerId() const
+{
+    if (!current_device)
+        return QString();
+#if defined(Q_OS_DARWIN)
+    return "ble-" + current_device->getDevice().deviceUuid().toString(QUuid::WithoutBraces);
+#else
+    return "ble-" + current_device->getDevice().address().toString();
+#endif
+}
@@ -10,15 +10,17 @@
 #include <QLowEnergyController>
 #include <QLowEnergyService>
 #include <QMetaEnum>
+#include <QTimer>
 #include <QLatin1String>
 #include <qregularexpression.h>
 #include <deviceinfo.h>
+#include "transport.h"
 
 #define SCANPARAMETERSUUID  "00001813-0000-1000-8000-00805f9b34fb"
 #define RXUUID              "0000AB01-0000-1000-8000-00805F9B34FB"  // For receiving commands
 #define TXUUID              "0000AB02-0000-1000-8000-00805F9B34FB"  // For sending measurements
 
-class BluetoothClient : public QObject
+class BluetoothClient : public Transport
 {
     Q_OBJECT
 
@@ -37,13 +39,22 @@ public:
     };
     Q_ENUM(bluetoothleState)
 
+    static constexpr int SCAN_TIMEOUT = 60000;
+    static constexpr int DIRECT_CONNECT_TIMEOUT = 5000;  // Fall back to scanning after this
+    static constexpr int RECONNECT_DELAY = 1000;
+
     BluetoothClient();
     ~BluetoothClient();
 
+    void start() override;
+    void stop() override;
+    void writeValue(const QByteArray &value) override;
+    bool isConnected() const override;
+    QString peerId() const override;
+
     void writeData(QByteArray data);
     void setState(BluetoothClient::bluetoothleState newState);
     BluetoothClient::bluetoothleState getState() const;
-    bool isConnected() const;
     void getDeviceList(QList<QString> &qlDevices);
     void disconnectFromDevice();
 
@@ -73,14 +84,18 @@ public slots:
     /* Slots for user */
     void startScan();
     void startConnect(int i);
+    bool connectToCachedDevice();
 
 signals:
     /* Signals for user */
     void statusChanged(const QString &status);
-    void newData(QByteArray data);
     void changedState(BluetoothClient::bluetoothleState newState);
 
 private:
+    void setupService();
+    void saveDevice();
+    void fallBackToScan();
+    void resetController();
 
     QLowEnergyController *m_control;
     QString m_service_name{"Bal"};
@@ -94,9 +109,16 @@ private:
     QLowEnergyDescriptor m_notificationDescTx;
     QLowEnergyDescriptor m_notificationDescRx;
     QLowEnergyService *m_UARTService;
-    bool m_bFoundUARTService;
+    bool m_bFoundUARTService{false};
     BluetoothClient::bluetoothleState m_state;
 
+    // Identity of the last device that delivered data, from QSettings
+    QTimer *m_directConnectTimer;
+    bool m_directConnect{false};
+    bool m_running{false};
+    QBluetoothUuid m_cachedRx;
+    QBluetoothUuid m_cachedTx;
+
     QLowEnergyCharacteristic m_readCharacteristic;
     QLowEnergyCharacteristic m_writeCharacteristic;
     QLowEnergyService::WriteMode m_writeMode;
@@ -0,0 +1,222 @@
+#include "dashboard.h"
+#include "deviceconnection.h"
+#include "devicepool.h"
+#include "framedecoder.h"
+#include "protocol.h"
+#include <QVBoxLayout>
+#include <algorithm>
+
+DeviceTile::DeviceTile(DeviceConnection *connection, QWidget *parent)
+    : QFrame(parent)
+    , m_connection(connection)
+{
+    setObjectName(connection->name() + connection->key());
+    setFrameShape(QFrame::StyledPanel);
+    setStyleSheet("DeviceTile { background-color: white; border-radius: 10px; }");
+
+    QVBoxLayout *layout = new QVBoxLayout(this);
+    layout->setSpacing(4);
+
+    m_nameLabel = new QLabel(connection->name(), this);
+    m_nameLabel->setStyleSheet("QLabel { font-size: 20px; font-weight: bold; }");
+    m_nameLabel->setAlignment(Qt::AlignCenter);
+    layout->addWidget(m_nameLabel);
+
+    m_valueLabel = new QLabel(this);
+    m_valueLabel->setAlignment(Qt::AlignCenter);
+    showBac(0.0f);
+    layout->addWidget(m_valueLabel);
+
+    m_r0Label = new QLabel("R0: -", this);
+    m_r0Label->setAlignment(Qt::AlignCenter);
+    layout->addWidget(m_r0Label);
+
+    m_statusLabel = new QLabel("Connecting", this);
+    m_statusLabel->setAlignment(Qt::AlignCenter);
+    layout->addWidget(m_statusLabel);
+
+    m_startStopButton = new QPushButton("Start", this);
+    m_startStopButton->setEnabled(false);
+    m_startStopButton->setStyleSheet(
+        "QPushButton { background-color: #4CAF50; color: white; border-radius: 6px; "
+        "padding: 8px; font-size: 16px; }"
+        "QPushButton:disabled { background-color: #9e9e9e; }");
+    layout->addWidget(m_startStopButton);
+
+    connect(m_startStopButton, &QPushButton::clicked, this, &DeviceTile::toggleMeasurement);
+    connect(connection, &Transport::connectionState, this, &DeviceTile::connectionStateChanged);
+    connect(connection, &Transport::sendInfo, m_statusLabel, &QLabel::setText);
+}
+
+bool DeviceTile::isConnected() const
+{
+    return m_connection->isConnected();
+}
+
+void DeviceTile::refresh()
+{
+    const MeterState state = m_connection->decoder()->state();
+    if (state.revision == m_shownRevision)
+        return;
+
+    m_shownRevision = state.revision;
+    showBac(state.bac);
+    m_r0Label->setText(QString("R0: %1").arg(QString::number(state.r0, 'f', 2)));
+    if (state.statusRevision != m_shownStatusRevision) {
+        m_shownStatusRevision = state.statusRevision;
+        m_statusLabel->setText(state.status);
+    }
+}
+
+void DeviceTile::connectionStateChanged(bool connected)
+{
+    m_startStopButton->setEnabled(connected);
+    if (connected) {
+        m_statusLabel->setText("Ready");
+        m_connection->writeValue(Protocol::encode<mR0, mRead>());
+    } else {
+        m_measuring = false;
+        m_startStopButton->setText("Start");
+        m_statusLabel->setText("Disconnected");
+    }
+}
+
+void DeviceTile::toggleMeasurement()
+{
+    m_measuring = !m_measuring;
+    if (m_measuring) {
+        m_connection->writeValue(Protocol::encode<mStart, mWrite>(0));
+        m_startStopButton->setText("Stop");
+    } else {
+        m_connection->writeValue(Protocol::encode<mStop, mWrite>(0));
+        m_startStopButton->setText("Start");
+        showBac(0.0f);
+    }
+}
+
+void DeviceTile::showBac(float bac)
+{
+    m_bac = bac;
+    m_valueLabel->setText(QString::number(bac, 'f', 2) + " mg/L");
+
+    // Stylesheets are only reparsed when the colour band changes
+    const BacBand band = bac < 0.3 ? BandLow : (bac < 0.5 ? BandWarning : BandHigh);
+    if (band == m_band)
+        return;
+
+    m_band = band;
+    const char *color = band == BandLow ? "green" : (band == BandWarning ? "orange" : "red");
+    m_valueLabel->setStyleSheet(QString("QLabel { font-size: 40px; font-weight: bold; color: %1; }").arg(color));
+}
+
+Dashboard::Dashboard(QWidget *parent)
+    : QWidget(parent)
+{
+    setWindowTitle("Alcohol Meter Stations");
+    setAttribute(Qt::WA_DeleteOnClose);
+    setStyleSheet("background-color: #f0f0f0;");
+
+    QVBoxLayout *mainLayout = new QVBoxLayout(this);
+    mainLayout->setContentsMargins(20, 20, 20, 20);
+
+    m_summaryLabel = new QLabel("No stations", this);
+    m_summaryLabel->setStyleSheet("QLabel { font-size: 28px; font-weight: bold; }");
+    m_summaryLabel->setAlignment(Qt::AlignCenter);
+    mainLayout->addWidget(m_summaryLabel);
+
+    m_statusLabel = new QLabel(this);
+    m_statusLabel->setAlignment(Qt::AlignCenter);
+    mainLayout->addWidget(m_statusLabel);
+
+    m_grid = new QGridLayout;
+    m_grid->setSpacing(10);
+    mainLayout->addLayout(m_grid, 1);
+
+    QPushButton *backButton = new QPushButton("Back", this);
+    backButton->setStyleSheet(
+        "QPushButton { background-color: #2196F3; color: white; border-radius: 10px; "
+        "padding: 20px; min-width: 200px; font-size: 24px; }");
+    mainLayout->addWidget(backButton);
+    connect(backButton, &QPushButton::clicked, this, &Dashboard::close);
+
+    m_pool = new DevicePool(this);
+    connect(m_pool, &DevicePool::connectionAdded, this, &Dashboard::addTile);
+    connect(m_pool, &DevicePool::connectionRemoved, this, &Dashboard::removeTile);
+    connect(m_pool, &DevicePool::statusChanged, m_statusLabel, &QLabel::setText);
+
+    // One timer for all tiles, so N stations cost one repaint pass per frame
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(REFRESH_INTERVAL);
+    connect(m_refreshTimer, &QTimer::timeout, this, &Dashboard::refresh);
+    m_refreshTimer->start();
+
+    m_pool->start();
+}
+
+Dashboard::~Dashboard()
+{
+    // Tiles refer to the pool's connections, drop them first
+    qDeleteAll(m_tiles);
+    m_tiles.clear();
+    delete m_pool;
+}
+
+void Dashboard::closeEvent(QCloseEvent *event)
+{
+    m_refreshTimer->stop();
+    m_pool->stop();
+    emit closed();
+    QWidget::closeEvent(event);
+}
+
+void Dashboard::addTile(DeviceConnection *connection)
+{
+    DeviceTile *tile = new DeviceTile(connection, this);
+    m_tiles.insert(connection->key(), tile);
+    relayout();
+}
+
+void Dashboard::removeTile(const QString &key)
+{
+    delete m_tiles.take(key);
+    relayout();
+}
+
+void Dashboard::relayout()
+{
+    // Tiles in a stable order by name, COLUMNS per row
+    QList<DeviceTile*> tiles = m_tiles.values();
+    std::sort(tiles.begin(), tiles.end(), [](DeviceTile *a, DeviceTile *b) {
+        return a->objectName() < b->objectName();
+    });
+    for (DeviceTile *tile : std::as_const(tiles)) {
+        m_grid->removeWidget(tile);
+    }
+    for (int i = 0; i < tiles.size(); ++i) {
+        m_grid->addWidget(tiles.at(i), i / COLUMNS, i % COLUMNS);
+    }
+}
+
+void Dashboard::refresh()
+{
+    int connected = 0;
+    int overLimit = 0;
+    float highest = 0.0f;
+    for (DeviceTile *tile : std::as_const(m_tiles)) {
+        tile->refresh();
+        if (!tile->isConnected())
+            continue;
+        connected++;
+        highest = qMax(highest, tile->bac());
+        if (tile->bac() >= 0.5f)
+            overLimit++;
+    }
+
+    const QString summary = QString("%1/%2 stations, highest %3 mg/L, %4 over limit")
+                                .arg(connected).arg(m_tiles.size())
+                                .arg(QString::number(highest, 'f', 2)).arg(overLimit);
+    if (summary != m_shownSummary) {
+        m_shownSummary = summary;
+        m_summaryLabel->setText(summary);
+    }
+}
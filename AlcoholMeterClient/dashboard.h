@@ -0,0 +1,85 @@
+#ifndef DASHBOARD_H
+#define DASHBOARD_H
+
+#include <QFrame>
+#include <QGridLayout>
+#include <QHash>
+#include <QLabel>
+#include <QPushButton>
+#include <QTimer>
+#include <QWidget>
+
+class DeviceConnection;
+class DevicePool;
+
+// One station of the dashboard: name, BAC, R0 and link state of a meter
+class DeviceTile : public QFrame
+{
+    Q_OBJECT
+
+public:
+    enum BacBand { BandNone, BandLow, BandWarning, BandHigh };
+
+    explicit DeviceTile(DeviceConnection *connection, QWidget *parent = nullptr);
+
+    // Pulls the decoder state, cheap when nothing changed
+    void refresh();
+
+    float bac() const { return m_bac; }
+    bool isConnected() const;
+
+private:
+    void connectionStateChanged(bool connected);
+    void toggleMeasurement();
+    void showBac(float bac);
+
+    DeviceConnection *m_connection;
+    quint64 m_shownRevision = 0;
+    quint64 m_shownStatusRevision = 0;
+    float m_bac = 0.0f;
+    BacBand m_band = BandNone;
+    bool m_measuring{false};
+
+    QLabel *m_nameLabel;
+    QLabel *m_valueLabel;
+    QLabel *m_r0Label;
+    QLabel *m_statusLabel;
+    QPushButton *m_startStopButton;
+};
+
+// Tiles for every meter of a DevicePool with a summary line on top
+class Dashboard : public QWidget
+{
+    Q_OBJECT
+
+public:
+    static constexpr int REFRESH_INTERVAL = 1000 / 30;   // Same cap as MainWindow
+    static constexpr int COLUMNS = 2;
+
+    explicit Dashboard(QWidget *parent = nullptr);
+    ~Dashboard();
+
+signals:
+    void closed();
+
+protected:
+    void closeEvent(QCloseEvent *event) override;
+
+private slots:
+    void addTile(DeviceConnection *connection);
+    void removeTile(const QString &key);
+    void refresh();
+
+private:
+    void relayout();
+
+    DevicePool *m_pool;
+    QHash<QString, DeviceTile*> m_tiles;
+    QTimer *m_refreshTimer;
+    QGridLayout *m_grid;
+    QLabel *m_summaryLabel;
+    QLabel *m_statusLabel;
+    QString m_shownSummary;
+};
+
+#endif // DASHBOARD_H
@@ -0,0 +1,110 @@
+#include "decimatingbuffer.h"
+
+namespace {
+
+void merge(DecimatingBuffer::Point &into, const DecimatingBuffer::Point &point)
+{
+    into.min = qMin(into.min, point.min);
+    into.max = qMax(into.max, point.max);
+}
+
+}
+
+DecimatingBuffer::DecimatingBuffer(int capacity, int levels, int factor)
+    : m_capacity(qMax(capacity, 2))
+    , m_factor(qMax(factor, 2))
+{
+    m_levels.resize(qMax(levels, 1));
+    for (Level &level : m_levels) {
+        level.ring.resize(m_capacity);
+    }
+}
+
+void DecimatingBuffer::append(qint64 time, float value)
+{
+    push(0, Point{time, value, value});
+}
+
+void DecimatingBuffer::clear()
+{
+    for (Level &level : m_levels) {
+        level.head = 0;
+        level.size = 0;
+        level.pendingCount = 0;
+    }
+}
+
+int DecimatingBuffer::levelFor(qint64 from, int maxPoints) const
+{
+    for (int i = 0; i < m_levels.size(); ++i) {
+        const Level &level = m_levels.at(i);
+        // A full ring whose oldest point is newer than from lost the start of the window
+        bool covers = level.size < m_capacity || at(level, 0).time <= from;
+        if (covers && level.size - firstIndex(level, from) <= maxPoints)
+            return i;
+    }
+    return m_levels.size() - 1;
+}
+
+void DecimatingBuffer::push(int index, const Point &point)
+{
+    Level &level = m_levels[index];
+    level.ring[level.head] = point;
+    level.head = (level.head + 1) % m_capacity;
+    level.size = qMin(level.size + 1, m_capacity);
+
+    if (index + 1 >= m_levels.size())
+        return;
+
+    Level &next = m_levels[index + 1];
+    if (next.pendingCount == 0)
+        next.pending = point;
+    else
+        merge(next.pending, point);
+
+    if (++next.pendingCount == m_factor) {
+        next.pendingCount = 0;
+        push(index + 1, next.pending);
+    }
+}
+
+const DecimatingBuffer::Point &DecimatingBuffer::at(const Level &level, int index) const
+{
+    int position = level.head - level.size + index;
+    if (position < 0)
+        position += m_capacity;
+    return level.ring.at(position);
+}
+
+int DecimatingBuffer::firstIndex(const Level &level, qint64 from) const
+{
+    // Times only grow, so binary search the first point at or after from
+    int low = 0;
+    int high = level.size;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (at(level, middle).time < from)
+            low = middle + 1;
+        else
+            high = middle;
+    }
+    return low;
+}
+
+bool DecimatingBuffer::pendingSince(int index, Point &point) const
+{
+    // Samples not yet folded into this level wait in the buckets of all finer levels
+    bool found = false;
+    for (int i = index; i > 0; --i) {
+        const Level &level = m_levels.at(i);
+        if (level.pendingCount == 0)
+            continue;
+        if (!found) {
+            point = level.pending;
+            found = true;
+        } else {
+            merge(point, level.pending);
+        }
+    }
+    return found;
+}
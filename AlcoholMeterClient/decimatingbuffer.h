@@ -0,0 +1,67 @@
+#ifndef DECIMATINGBUFFER_H
+#define DECIMATINGBUFFER_H
+
+#include <QtGlobal>
+#include <QVector>
+
+// Fixed capacity time series with min/max level of detail. Level 0 holds
+// raw samples, every further level holds min/max envelopes of FACTOR
+// entries of the level below, each level in its own ring of the same
+// capacity. A plot picks the finest level whose points still fit its
+// width, so drawing minutes of full rate data touches at most a few
+// thousand points and spikes never disappear.
+class DecimatingBuffer
+{
+public:
+    struct Point {
+        qint64 time;        // ms, of the first sample in the bucket
+        float min;
+        float max;
+    };
+
+    explicit DecimatingBuffer(int capacity = 2048, int levels = 4, int factor = 8);
+
+    void append(qint64 time, float value);
+    void clear();
+
+    bool isEmpty() const { return m_levels.first().size == 0; }
+    int levelCount() const { return m_levels.size(); }
+
+    // Finest level holding everything since from in at most maxPoints points
+    int levelFor(qint64 from, int maxPoints) const;
+
+    // Calls f(const Point &) oldest first for the points of a level since
+    // from, including the newest partially filled bucket
+    template<typename F>
+    void forEach(int level, qint64 from, F f) const
+    {
+        const Level &l = m_levels.at(level);
+        for (int i = firstIndex(l, from); i < l.size; ++i) {
+            f(at(l, i));
+        }
+
+        Point pending;
+        if (level > 0 && pendingSince(level, pending) && pending.time >= from)
+            f(pending);
+    }
+
+private:
+    struct Level {
+        QVector<Point> ring;
+        int head = 0;       // Next write position
+        int size = 0;
+        Point pending{};    // Bucket being filled from the level below
+        int pendingCount = 0;
+    };
+
+    void push(int level, const Point &point);
+    const Point &at(const Level &level, int index) const;
+    int firstIndex(const Level &level, qint64 from) const;
+    bool pendingSince(int level, Point &point) const;
+
+    QVector<Level> m_levels;
+    int m_capacity;
+    int m_factor;
+};
+
+#endif // DECIMATINGBUFFER_H
@@ -0,0 +1,222 @@
+#include "deviceconnection.h"
+#include "bluetoothclient.h"
+#include "framedecoder.h"
+#include <QDebug>
+
+DeviceConnection::DeviceConnection(const QBluetoothDeviceInfo &device, QObject *parent)
+    : Transport(parent)
+    , m_device(device)
+{
+    // Lives on the pool's decoder thread once moved there
+    m_decoder = new FrameDecoder;
+    connect(this, &Transport::dataReceived, m_decoder, &FrameDecoder::decode);
+
+    m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setSingleShot(true);
+    m_reconnectTimer->setInterval(RECONNECT_DELAY);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &DeviceConnection::connectDevice);
+}
+
+DeviceConnection::~DeviceConnection()
+{
+    stop();
+    m_decoder->deleteLater();
+}
+
+QString DeviceConnection::keyOf(const QBluetoothDeviceInfo &device)
+{
+#if defined(Q_OS_DARWIN)
+    return device.deviceUuid().toString();
+#else
+    return device.address().toString();
+#endif
+}
+
+QString DeviceConnection::key() const
+{
+    return keyOf(m_device);
+}
+
+QString DeviceConnection::name() const
+{
+    return m_device.name();
+}
+
+FrameDecoder *DeviceConnection::decoder() const
+{
+    return m_decoder;
+}
+
+void DeviceConnection::start()
+{
+    if (m_running)
+        return;
+    m_running = true;
+    m_failedReconnects = 0;
+    connectDevice();
+}
+
+void DeviceConnection::stop()
+{
+    m_running = false;
+    m_reconnectTimer->stop();
+    reset();
+    setConnected(false);
+}
+
+void DeviceConnection::writeValue(const QByteArray &value)
+{
+    if (m_connected && m_service && m_writeCharacteristic.isValid())
+        m_service->writeCharacteristic(m_writeCharacteristic, value, m_writeMode);
+}
+
+bool DeviceConnection::isConnected() const
+{
+    return m_connected;
+}
+
+void DeviceConnection::connectDevice()
+{
+    if (!m_running)
+        return;
+
+    reset();
+    m_control = QLowEnergyController::createCentral(m_device, this);
+    m_control->setRemoteAddressType(QLowEnergyController::RandomAddress);
+    connect(m_control, &QLowEnergyController::connected, this, &DeviceConnection::onConnected);
+    connect(m_control, &QLowEnergyController::disconnected, this, &DeviceConnection::onDisconnected);
+    connect(m_control, &QLowEnergyController::errorOccurred, this, &DeviceConnection::onControllerError);
+    connect(m_control, &QLowEnergyController::serviceDiscovered, this, &DeviceConnection::onServiceDiscovered);
+    connect(m_control, &QLowEnergyController::discoveryFinished, this, &DeviceConnection::onDiscoveryFinished);
+
+    emit sendInfo(QString("Connecting to %1").arg(name()));
+    m_control->connectToDevice();
+}
+
+void DeviceConnection::reset()
+{
+    delete m_service;
+    m_service = nullptr;
+    m_writeCharacteristic = QLowEnergyCharacteristic();
+
+    if (m_control) {
+        m_control->disconnect(this);
+        m_control->disconnectFromDevice();
+        m_control->deleteLater();
+        m_control = nullptr;
+    }
+}
+
+void DeviceConnection::setConnected(bool connected)
+{
+    if (m_connected == connected)
+        return;
+    m_connected = connected;
+    if (connected)
+        m_failedReconnects = 0;
+    emit connectionState(connected);
+}
+
+void DeviceConnection::scheduleReconnect()
+{
+    setConnected(false);
+    if (!m_running || m_reconnectTimer->isActive())
+        return;
+
+    if (++m_failedReconnects > MAX_RECONNECTS) {
+        qDebug() << name() << "unreachable after" << MAX_RECONNECTS << "reconnects";
+        emit sendInfo(QString("%1 lost").arg(name()));
+        emit lost();
+        return;
+    }
+    m_reconnectTimer->start();
+}
+
+void DeviceConnection::onConnected()
+{
+    m_control->discoverServices();
+}
+
+void DeviceConnection::onDisconnected()
+{
+    emit sendInfo(QString("%1 disconnected").arg(name()));
+    scheduleReconnect();
+}
+
+void DeviceConnection::onControllerError(QLowEnergyController::Error error)
+{
+    qDebug() << name() << "controller error" << error;
+    emit sendInfo(QString("%1: %2").arg(name(), m_control ? m_control->errorString() : QString()));
+    scheduleReconnect();
+}
+
+void DeviceConnection::onServiceDiscovered(const QBluetoothUuid &uuid)
+{
+    // Take the meter's service as soon as it shows up
+    if (uuid == QBluetoothUuid(QUuid(SCANPARAMETERSUUID)) && !m_service)
+        setupService();
+}
+
+void DeviceConnection::onDiscoveryFinished()
+{
+    if (!m_service) {
+        emit sendInfo(QString("%1 has no meter service").arg(name()));
+        scheduleReconnect();
+    }
+}
+
+void DeviceConnection::setupService()
+{
+    m_service = m_control->createServiceObject(QBluetoothUuid(QUuid(SCANPARAMETERSUUID)), this);
+    if (!m_service)
+        return;
+
+    connect(m_service, &QLowEnergyService::stateChanged, this, &DeviceConnection::onServiceStateChanged);
+    connect(m_service, &QLowEnergyService::characteristicChanged, this, &DeviceConnection::onCharacteristicChanged);
+    connect(m_service, &QLowEnergyService::descriptorWritten, this, &DeviceConnection::onDescriptorWritten);
+    m_service->discoverDetails(QLowEnergyService::SkipValueDiscovery);
+}
+
+void DeviceConnection::onServiceStateChanged(QLowEnergyService::ServiceState state)
+{
+    if (state != QLowEnergyService::ServiceDiscovered)
+        return;
+
+    // Same selection as BluetoothClient: a writable characteristic for
+    // commands, a notifying one for measurements
+    const QList<QLowEnergyCharacteristic> characteristics = m_service->characteristics();
+    QLowEnergyDescriptor notification;
+    for (const QLowEnergyCharacteristic &c : characteristics) {
+        if (c.properties() & (QLowEnergyCharacteristic::WriteNoResponse | QLowEnergyCharacteristic::Write)) {
+            m_writeCharacteristic = c;
+            m_writeMode = (c.properties() & QLowEnergyCharacteristic::WriteNoResponse)
+                              ? QLowEnergyService::WriteWithoutResponse : QLowEnergyService::WriteWithResponse;
+        }
+        if (c.properties() & (QLowEnergyCharacteristic::Notify | QLowEnergyCharacteristic::Read)) {
+            QLowEnergyDescriptor descriptor = c.descriptor(QBluetoothUuid::DescriptorType::ClientCharacteristicConfiguration);
+            if (descriptor.isValid())
+                notification = descriptor;
+        }
+    }
+
+    if (!notification.isValid() || !m_writeCharacteristic.isValid()) {
+        emit sendInfo(QString("%1 has no usable characteristics").arg(name()));
+        scheduleReconnect();
+        return;
+    }
+    m_service->writeDescriptor(notification, QByteArray::fromHex("0100"));
+}
+
+void DeviceConnection::onCharacteristicChanged(const QLowEnergyCharacteristic &c, const QByteArray &value)
+{
+    Q_UNUSED(c)
+    emit dataReceived(value);
+}
+
+void DeviceConnection::onDescriptorWritten(const QLowEnergyDescriptor &d, const QByteArray &value)
+{
+    Q_UNUSED(d)
+    Q_UNUSED(value)
+    emit sendInfo(QString("%1 connected").arg(name()));
+    setConnected(true);
+}
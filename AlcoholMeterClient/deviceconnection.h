@@ -0,0 +1,72 @@
+#ifndef DEVICECONNECTION_H
+#define DEVICECONNECTION_H
+
+#include <QBluetoothDeviceInfo>
+#include <QLowEnergyController>
+#include <QLowEnergyService>
+#include <QTimer>
+#include "transport.h"
+
+class FrameDecoder;
+
+// GATT link to one known AlcoholMeter, with its own controller, service
+// and decoder. Reconnects by itself until stopped, or until MAX_RECONNECTS
+// attempts in a row have failed and it reports itself lost. Used by DevicePool for
+// the multi-device dashboard; the single device screen uses BluetoothClient.
+class DeviceConnection : public Transport
+{
+    Q_OBJECT
+
+public:
+    static constexpr int RECONNECT_DELAY = 2000;
+    static constexpr int MAX_RECONNECTS = 15;      // Failed attempts in a row before giving up
+
+    explicit DeviceConnection(const QBluetoothDeviceInfo &device, QObject *parent = nullptr);
+    ~DeviceConnection();
+
+    // Stable identifier of a device: its address, or the device UUID on Apple
+    static QString keyOf(const QBluetoothDeviceInfo &device);
+
+    QString key() const;
+    QString name() const;
+    FrameDecoder *decoder() const;
+
+    void start() override;
+    void stop() override;
+    void writeValue(const QByteArray &value) override;
+    bool isConnected() const override;
+
+signals:
+    // The station stayed out of reach, no more reconnects are scheduled
+    void lost();
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onControllerError(QLowEnergyController::Error error);
+    void onServiceDiscovered(const QBluetoothUuid &uuid);
+    void onDiscoveryFinished();
+    void onServiceStateChanged(QLowEnergyService::ServiceState state);
+    void onCharacteristicChanged(const QLowEnergyCharacteristic &c, const QByteArray &value);
+    void onDescriptorWritten(const QLowEnergyDescriptor &d, const QByteArray &value);
+
+private:
+    void connectDevice();
+    void setupService();
+    void reset();
+    void setConnected(bool connected);
+    void scheduleReconnect();
+
+    QBluetoothDeviceInfo m_device;
+    QLowEnergyController *m_control{nullptr};
+    QLowEnergyService *m_service{nullptr};
+    QLowEnergyCharacteristic m_writeCharacteristic;
+    QLowEnergyService::WriteMode m_writeMode{QLowEnergyService::WriteWithResponse};
+    FrameDecoder *m_decoder;
+    QTimer *m_reconnectTimer;
+    bool m_running{false};
+    bool m_connected{false};
+    int m_failedReconnects{0};
+};
+
+#endif // DEVICECONNECTION_H
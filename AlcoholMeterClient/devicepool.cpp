@@ -0,0 +1,126 @@
+#include "devicepool.h"
+#include "deviceconnection.h"
+#include "framedecoder.h"
+#include <QDebug>
+
+DevicePool::DevicePool(QObject *parent)
+    : QObject(parent)
+{
+    m_agent = new QBluetoothDeviceDiscoveryAgent(this);
+    m_agent->setLowEnergyDiscoveryTimeout(SCAN_TIMEOUT);
+    connect(m_agent, &QBluetoothDeviceDiscoveryAgent::deviceDiscovered, this, &DevicePool::addDevice);
+    connect(m_agent, &QBluetoothDeviceDiscoveryAgent::finished, this, &DevicePool::scanFinished);
+    connect(m_agent, &QBluetoothDeviceDiscoveryAgent::errorOccurred, this, &DevicePool::scanError);
+
+    m_rescanTimer = new QTimer(this);
+    m_rescanTimer->setSingleShot(true);
+    m_rescanTimer->setInterval(RESCAN_INTERVAL);
+    connect(m_rescanTimer, &QTimer::timeout, this, &DevicePool::scan);
+
+    m_decoderThread.setObjectName("pooldecoder");
+    m_decoderThread.start();
+}
+
+DevicePool::~DevicePool()
+{
+    stop();
+    qDeleteAll(m_connections);
+    m_connections.clear();
+    m_decoderThread.quit();
+    m_decoderThread.wait();
+}
+
+void DevicePool::start()
+{
+    if (m_running)
+        return;
+    m_running = true;
+    for (DeviceConnection *connection : std::as_const(m_connections)) {
+        connection->start();
+    }
+    scan();
+}
+
+void DevicePool::stop()
+{
+    m_running = false;
+    m_rescanTimer->stop();
+    m_agent->stop();
+    for (DeviceConnection *connection : std::as_const(m_connections)) {
+        connection->stop();
+    }
+}
+
+QList<DeviceConnection*> DevicePool::connections() const
+{
+    return m_connections.values();
+}
+
+DeviceConnection *DevicePool::connection(const QString &key) const
+{
+    return m_connections.value(key);
+}
+
+void DevicePool::remove(const QString &key)
+{
+    DeviceConnection *connection = m_connections.take(key);
+    if (!connection)
+        return;
+
+    delete connection;
+    emit connectionRemoved(key);
+    if (m_running && !m_agent->isActive() && !m_rescanTimer->isActive())
+        m_rescanTimer->start();
+}
+
+void DevicePool::scan()
+{
+    if (!m_running || m_connections.size() >= MAX_DEVICES)
+        return;
+
+    emit statusChanged("Scanning for meters");
+    m_agent->start(QBluetoothDeviceDiscoveryAgent::LowEnergyMethod);
+}
+
+void DevicePool::addDevice(const QBluetoothDeviceInfo &device)
+{
+    if (!(device.coreConfigurations() & QBluetoothDeviceInfo::LowEnergyCoreConfiguration))
+        return;
+    if (!device.name().startsWith("Alcohol"))
+        return;
+
+    // Unlike BluetoothClient, keep scanning for the other stations
+    const QString key = DeviceConnection::keyOf(device);
+    if (m_connections.contains(key) || m_connections.size() >= MAX_DEVICES)
+        return;
+
+    qDebug() << "Adding meter" << device.name() << key;
+    auto *connection = new DeviceConnection(device, this);
+    connection->decoder()->moveToThread(&m_decoderThread);
+    connect(&m_decoderThread, &QThread::finished, connection->decoder(), &QObject::deleteLater);
+    m_connections.insert(key, connection);
+    // Frees the slot of a station that left, a later scan adds it again.
+    // Queued, the connection is deleted outside its own signal.
+    connect(connection, &DeviceConnection::lost, this, [this, key]() { remove(key); }, Qt::QueuedConnection);
+    emit connectionAdded(connection);
+
+    if (m_running)
+        connection->start();
+    if (m_connections.size() >= MAX_DEVICES)
+        m_agent->stop();
+}
+
+void DevicePool::scanFinished()
+{
+    emit statusChanged(QString("%1 meter(s) found").arg(m_connections.size()));
+    if (m_running)
+        m_rescanTimer->start();
+}
+
+void DevicePool::scanError(QBluetoothDeviceDiscoveryAgent::Error error)
+{
+    qDebug() << "Pool scan error" << error << m_agent->errorString();
+    emit statusChanged(m_agent->errorString());
+    if (m_running)
+        m_rescanTimer->start();
+}
@@ -0,0 +1,52 @@
+#ifndef DEVICEPOOL_H
+#define DEVICEPOOL_H
+
+#include <QBluetoothDeviceDiscoveryAgent>
+#include <QHash>
+#include <QThread>
+#include <QTimer>
+
+class DeviceConnection;
+
+// Finds every AlcoholMeter in range and keeps one DeviceConnection per
+// device, keyed by address. The decoders of all connections share one
+// worker thread.
+class DevicePool : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int MAX_DEVICES = 7;          // Practical LE link limit of phone controllers
+    static constexpr int SCAN_TIMEOUT = 10000;
+    static constexpr int RESCAN_INTERVAL = 30000;  // Look for new stations while below MAX_DEVICES
+
+    explicit DevicePool(QObject *parent = nullptr);
+    ~DevicePool();
+
+    void start();
+    void stop();
+
+    QList<DeviceConnection*> connections() const;
+    DeviceConnection *connection(const QString &key) const;
+    void remove(const QString &key);
+
+signals:
+    void connectionAdded(DeviceConnection *connection);
+    void connectionRemoved(const QString &key);
+    void statusChanged(const QString &status);
+
+private slots:
+    void addDevice(const QBluetoothDeviceInfo &device);
+    void scanFinished();
+    void scanError(QBluetoothDeviceDiscoveryAgent::Error error);
+    void scan();
+
+private:
+    QBluetoothDeviceDiscoveryAgent *m_agent;
+    QTimer *m_rescanTimer;
+    QHash<QString, DeviceConnection*> m_connections;
+    QThread m_decoderThread;
+    bool m_running{false};
+};
+
+#endif // DEVICEPOOL_H
@@ -0,0 +1,111 @@
+#include "framedecoder.h"
+#include "livechart.h"
+#include <QDateTime>
+#include <QMutexLocker>
+
+FrameDecoder::FrameDecoder(QObject *parent) : QObject(parent)
+{
+}
+
+void FrameDecoder::setSeries(ChartSeries *bac, ChartSeries *volt)
+{
+    m_bacSeries = bac;
+    m_voltSeries = volt;
+}
+
+MeterState FrameDecoder::state() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_state;
+}
+
+void FrameDecoder::decode(const QByteArray &data)
+{
+    Protocol::Frame frame;
+    if (!Protocol::parseFrame(data, frame) || frame.rw != mWrite)
+        return;
+
+    // Tagged frames answer someone's read, only untagged ones are telemetry
+    if (frame.id)
+        return;
+
+    switch (frame.command) {
+    case mR0:
+    {
+        float r0 = 0;
+        if (!Protocol::decode<mR0, mWrite>(frame, r0))
+            return;
+        QMutexLocker locker(&m_mutex);
+        m_state.r0 = r0;
+        m_state.revision++;
+        break;
+    }
+    case mCalcVal0:
+    {
+        float bac = 0;
+        if (!Protocol::decode<mCalcVal0, mWrite>(frame, bac))
+            return;
+        if (m_bacSeries)
+            m_bacSeries->append(QDateTime::currentMSecsSinceEpoch(), bac);
+        QMutexLocker locker(&m_mutex);
+        m_state.bac = bac;
+        m_state.revision++;
+        break;
+    }
+    case mAdc0:
+    {
+        float volt = 0;
+        if (!Protocol::decode<mAdc0, mWrite>(frame, volt))
+            return;
+        if (m_voltSeries)
+            m_voltSeries->append(QDateTime::currentMSecsSinceEpoch(), volt);
+        QMutexLocker locker(&m_mutex);
+        m_state.volt = volt;
+        m_state.revision++;
+        break;
+    }
+    case mString:
+    {
+        QByteArray text;
+        Protocol::decode<mString, mWrite>(frame, text);
+        QString status = QString::fromLocal8Bit(text).simplified();
+        QMutexLocker locker(&m_mutex);
+        m_state.status = status;
+        m_state.statusRevision++;
+        m_state.revision++;
+        break;
+    }
+    case mFault:
+    {
+        SensorFault fault;
+        if (!Protocol::decode<mFault, mWrite>(frame, fault))
+            return;
+        // Shown in place of the status text until the device sends a new one
+        QString status = fault.kind == SensorFault::None
+                ? QString("Sensor OK")
+                : QString("Sensor fault: %1").arg(sensorFaultName(fault.kind));
+        QMutexLocker locker(&m_mutex);
+        m_state.fault = fault.kind;
+        m_state.status = status;
+        m_state.statusRevision++;
+        m_state.revision++;
+        break;
+    }
+    case mSyncBatch:
+    {
+        QByteArray chunk;
+        if (Protocol::decode<mSyncBatch, mWrite>(frame, chunk))
+            emit syncBatch(chunk);
+        break;
+    }
+    case mSyncDone:
+    {
+        Protocol::SyncState state{};
+        if (Protocol::decode<mSyncDone, mWrite>(frame, state))
+            emit syncDone(state.nextSequence, state.epoch);
+        break;
+    }
+    default:
+        break;
+    }
+}
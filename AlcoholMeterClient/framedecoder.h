@@ -0,0 +1,52 @@
+#ifndef FRAMEDECODER_H
+#define FRAMEDECODER_H
+
+#include <QObject>
+#include <QMutex>
+#include <QString>
+#include "protocol.h"
+
+class ChartSeries;
+
+// Latest known state of the device. Every change bumps revision, the status
+// text has its own counter so other status sources are not overwritten.
+struct MeterState {
+    float bac = 0.0f;
+    float r0 = 0.18f;
+    float volt = 0.0f;
+    quint8 fault = 0;           // SensorFault::Kind of the last mFault
+    QString status;
+    quint64 revision = 0;
+    quint64 statusRevision = 0;
+};
+
+// Decodes incoming frames on a worker thread into a MeterState. The UI
+// polls state() at its own frame rate instead of reacting to every packet.
+// History sync frames are passed on as signals.
+class FrameDecoder : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit FrameDecoder(QObject *parent = nullptr);
+
+    MeterState state() const;
+
+    // Every BAC and voltage sample is also appended to these, if set
+    void setSeries(ChartSeries *bac, ChartSeries *volt);
+
+public slots:
+    void decode(const QByteArray &data);
+
+signals:
+    void syncBatch(const QByteArray &chunk);
+    void syncDone(quint32 deviceSequence, quint32 epoch);
+
+private:
+    mutable QMutex m_mutex;
+    MeterState m_state;
+    ChartSeries *m_bacSeries{nullptr};
+    ChartSeries *m_voltSeries{nullptr};
+};
+
+#endif // FRAMEDECODER_H
@@ -0,0 +1,303 @@
+#include "historysync.h"
+#include <QDateTime>
+#include <QDir>
+#include <QFileInfo>
+#include <QRegularExpression>
+#include <QSettings>
+#include <QStandardPaths>
+#include <QDebug>
+#include <cstring>
+
+HistorySync::HistorySync(QObject *parent) : QObject(parent)
+{
+    m_timeout = new QTimer(this);
+    m_timeout->setSingleShot(true);
+    m_timeout->setInterval(SYNC_TIMEOUT);
+    connect(m_timeout, &QTimer::timeout, this, [this]() {
+        qWarning() << "History sync timed out at" << m_nextSequence;
+        resetBatch();
+        retry();
+    });
+
+    m_retryTimer = new QTimer(this);
+    m_retryTimer->setSingleShot(true);
+    connect(m_retryTimer, &QTimer::timeout, this, &HistorySync::request);
+
+    m_directory = QStandardPaths::writableLocation(QStandardPaths::AppDataLocation);
+    QDir().mkpath(m_directory);
+    openFile(QDir(m_directory).filePath("history.aml"));
+    loadMark();
+}
+
+HistorySync::~HistorySync()
+{
+    m_file.close();
+}
+
+void HistorySync::setDevice(const QString &device)
+{
+    QString name = device;
+    name.replace(QRegularExpression("[^A-Za-z0-9-]"), "_");
+    if (name == m_device)
+        return;
+
+    // Marks of different devices are unrelated, each has its own history
+    stop();
+    m_file.close();
+    m_device = name;
+    openFile(QDir(m_directory).filePath(m_device.isEmpty() ? QString("history.aml")
+                                                           : QString("history-%1.aml").arg(m_device)));
+    loadMark();
+}
+
+quint32 HistorySync::nextSequence() const
+{
+    return m_nextSequence;
+}
+
+quint64 HistorySync::recordCount() const
+{
+    return m_recordCount;
+}
+
+bool HistorySync::isSyncing() const
+{
+    return m_syncing;
+}
+
+void HistorySync::begin()
+{
+    m_syncing = true;
+    m_retries = 0;
+    m_retryTimer->stop();
+    resetBatch();
+    request();
+}
+
+void HistorySync::stop()
+{
+    m_timeout->stop();
+    m_retryTimer->stop();
+    m_syncing = false;
+    resetBatch();
+}
+
+void HistorySync::request()
+{
+    if (!m_syncing)
+        return;
+
+    m_timeout->start();
+    emit requestSync(m_nextSequence);
+}
+
+void HistorySync::retry()
+{
+    if (++m_retries > MAX_RETRIES) {
+        // The device is there but does not answer, leave it until the next connection
+        const QString reason = QString("History sync stopped at record %1 after %2 retries")
+                                   .arg(m_nextSequence).arg(MAX_RETRIES);
+        qWarning().noquote() << reason;
+        stop();
+        emit failed(reason);
+        return;
+    }
+
+    m_timeout->stop();
+    m_retryTimer->start(RETRY_DELAY * m_retries);
+}
+
+void HistorySync::handleBatch(const QByteArray &payload)
+{
+    if (!m_syncing || payload.size() <= static_cast<int>(sizeof(SyncChunkHeader)))
+        return;
+
+    SyncChunkHeader header;
+    memcpy(&header, payload.constData(), sizeof(header));
+    if (!checkEpoch(header.epoch))
+        return;
+
+    if (header.chunkIndex == 0) {
+        resetBatch();
+        m_batchSequence = header.firstSequence;
+        m_batchChunks = header.chunkCount;
+        m_batchRecords = header.recordCount;
+    } else if (m_batchChunks == 0) {
+        // Waiting for the start of the next batch after a loss
+        return;
+    } else if (header.firstSequence != m_batchSequence || header.chunkIndex != m_nextChunk) {
+        // A chunk went missing, ask again from what is already stored
+        qWarning() << "History sync lost chunk" << m_nextChunk << "of batch" << m_batchSequence;
+        resetBatch();
+        retry();
+        return;
+    }
+
+    m_timeout->start();
+    m_batch.append(payload.constData() + sizeof(header), payload.size() - sizeof(header));
+    m_nextChunk++;
+
+    if (m_nextChunk < m_batchChunks)
+        return;
+
+    const quint32 batchEnd = m_batchSequence + m_batchRecords;
+    const bool stored = storeBatch();
+    resetBatch();
+    if (stored) {
+        m_retries = 0;
+        request();
+    } else if (m_retries < MAX_RETRIES) {
+        retry();
+    } else {
+        // The device keeps sending this batch damaged, skip it instead of asking forever
+        const QString reason = QString("History records %1 to %2 skipped, the batch is corrupt")
+                                   .arg(m_nextSequence).arg(batchEnd - 1);
+        qWarning().noquote() << reason;
+        emit failed(reason);
+        setNextSequence(qMax(m_nextSequence, batchEnd));
+        m_retries = 0;
+        request();
+    }
+}
+
+void HistorySync::handleDone(quint32 deviceSequence, quint32 epoch)
+{
+    if (!m_syncing)
+        return;
+
+    // A device without a log reports neither, there is nothing to compare
+    if ((deviceSequence != 0 || epoch != 0) && !checkEpoch(epoch))
+        return;
+
+    // A mark without an epoch only notices a restarted log that is still
+    // shorter than what the client has
+    if (deviceSequence < m_nextSequence) {
+        rotateFile();
+        setNextSequence(0);
+        request();
+        return;
+    }
+
+    m_timeout->stop();
+    m_syncing = false;
+    emit finished(m_recordCount);
+}
+
+bool HistorySync::checkEpoch(quint32 epoch)
+{
+    if (m_epochKnown && epoch == m_epoch)
+        return true;
+
+    if (!m_epochKnown) {
+        setEpoch(epoch);
+        return true;
+    }
+
+    // The device log started from scratch, whatever its sequences are now.
+    // They repeat what the client has, so they go to a new file.
+    qDebug() << "Device log epoch changed from" << m_epoch << "to" << epoch;
+    if (m_recordCount > 0)
+        rotateFile();
+    setNextSequence(0);
+    setEpoch(epoch);
+    resetBatch();
+    request();
+    return false;
+}
+
+void HistorySync::setEpoch(quint32 epoch)
+{
+    m_epoch = epoch;
+    m_epochKnown = true;
+    QSettings().setValue(settingsKey("epoch"), m_epoch);
+}
+
+void HistorySync::loadMark()
+{
+    QSettings settings;
+    m_nextSequence = settings.value(settingsKey("nextSequence"), 0).toUInt();
+    m_epochKnown = settings.contains(settingsKey("epoch"));
+    m_epoch = settings.value(settingsKey("epoch"), 0).toUInt();
+}
+
+void HistorySync::openFile(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Append)) {
+        qWarning() << "Can not open history file" << m_file.fileName() << m_file.errorString();
+    }
+
+    // Only whole records count, a partial one from an interrupted write is overwritten
+    m_recordCount = m_file.size() / sizeof(LogRecord);
+    m_file.resize(m_recordCount * sizeof(LogRecord));
+}
+
+void HistorySync::rotateFile()
+{
+    const QString path = m_file.fileName();
+    const QFileInfo info(path);
+    const QString archive = info.dir().filePath(QString("%1-%2.aml").arg(info.completeBaseName(),
+                                                QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss")));
+    m_file.close();
+    if (QFile::rename(path, archive))
+        qDebug() << "Device log restarted, history archived as" << archive;
+    else
+        qWarning() << "Can not archive history file" << path << "- starting it over";
+
+    openFile(path);
+    m_file.resize(0);
+    m_recordCount = 0;
+}
+
+void HistorySync::resetBatch()
+{
+    m_batch.clear();
+    m_batchSequence = 0;
+    m_batchChunks = 0;
+    m_batchRecords = 0;
+    m_nextChunk = 0;
+}
+
+bool HistorySync::storeBatch()
+{
+    QByteArray records = qUncompress(m_batch);
+    if (records.size() != m_batchRecords * static_cast<int>(sizeof(LogRecord))) {
+        qWarning() << "History sync batch" << m_batchSequence << "is corrupt";
+        return false;
+    }
+
+    const LogRecord *batch = reinterpret_cast<const LogRecord*>(records.constData());
+    quint32 nextSequence = m_nextSequence;
+    QByteArray accepted;
+    accepted.reserve(records.size());
+    for (int i = 0; i < m_batchRecords; i++) {
+        // Skip duplicates of what a previous, interrupted batch already delivered
+        if (batch[i].sequence < nextSequence || batch[i].checksum != logRecordChecksum(batch[i]))
+            continue;
+        accepted.append(reinterpret_cast<const char*>(&batch[i]), sizeof(LogRecord));
+        nextSequence = batch[i].sequence + 1;
+    }
+
+    if (!accepted.isEmpty()) {
+        m_file.write(accepted);
+        m_file.flush();
+        m_recordCount += accepted.size() / sizeof(LogRecord);
+    }
+
+    // The mark only moves once the records are on disk
+    setNextSequence(nextSequence);
+    emit progress(m_recordCount);
+    return true;
+}
+
+void HistorySync::setNextSequence(quint32 sequence)
+{
+    m_nextSequence = sequence;
+    QSettings().setValue(settingsKey("nextSequence"), m_nextSequence);
+}
+
+QString HistorySync::settingsKey(const QString &name) const
+{
+    return m_device.isEmpty() ? QString("history/%1").arg(name)
+                              : QString("history/%1/%2").arg(m_device, name);
+}
@@ -0,0 +1,82 @@
+#ifndef HISTORYSYNC_H
+#define HISTORYSYNC_H
+
+#include <QObject>
+#include <QFile>
+#include <QByteArray>
+#include <QTimer>
+#include "logrecord.h"
+
+// Collects the device's measurement log on the phone. The client keeps a
+// high-water mark (the next sequence it wants) in QSettings and a local
+// file for every device it syncs with; every complete
+// batch is appended to a local file before the mark moves, so a sync cut
+// short by a disconnect resumes from the last stored batch. The device
+// answers each request with one batch, the next one is requested as soon
+// as the previous is stored. The device log is known by its epoch, kept
+// next to the mark; when the device reports another one its log started
+// over, the local file is archived and a new one begins with it.
+class HistorySync : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int SYNC_TIMEOUT = 5000;  // Re-request a batch that stopped arriving
+    static constexpr int MAX_RETRIES = 3;      // Failed requests in a row before giving up on a batch
+    static constexpr int RETRY_DELAY = 1000;   // ms, grows with every retry
+
+    explicit HistorySync(QObject *parent = nullptr);
+    ~HistorySync();
+
+    // Selects the mark and the file of a device, see Transport::peerId()
+    void setDevice(const QString &device);
+
+    quint32 nextSequence() const;
+    quint64 recordCount() const;
+    bool isSyncing() const;
+
+    void begin();
+    void stop();
+    void handleBatch(const QByteArray &payload);
+    void handleDone(quint32 deviceSequence, quint32 epoch);
+
+signals:
+    void requestSync(quint32 sequence);
+    void progress(quint64 records);
+    void finished(quint64 records);
+    void failed(const QString &reason);
+
+private:
+    void request();
+    void retry();
+    void resetBatch();
+    bool storeBatch();
+    void setNextSequence(quint32 sequence);
+    bool checkEpoch(quint32 epoch);
+    void setEpoch(quint32 epoch);
+    void loadMark();
+    void openFile(const QString &path);
+    QString settingsKey(const QString &name) const;
+    void rotateFile();
+
+    QString m_directory;
+    QString m_device;                       // Safe for file names, empty for the unnamed device
+    QFile m_file;
+    QTimer *m_timeout;
+    QTimer *m_retryTimer;
+    int m_retries = 0;                      // Failed requests since the mark last moved
+    quint32 m_nextSequence = 0;
+    quint32 m_epoch = 0;
+    bool m_epochKnown = false;              // Marks from before the epoch have none
+    quint64 m_recordCount = 0;
+    bool m_syncing = false;
+
+    // Batch being reassembled
+    quint32 m_batchSequence = 0;
+    int m_batchChunks = 0;
+    int m_nextChunk = 0;
+    int m_batchRecords = 0;
+    QByteArray m_batch;
+};
+
+#endif // HISTORYSYNC_H
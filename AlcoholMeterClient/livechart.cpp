@@ -0,0 +1,133 @@
+#include "livechart.h"
+#include <QDateTime>
+#include <QMutexLocker>
+#include <QPainter>
+#include <QPainterPath>
+#include <cmath>
+#include <limits>
+
+ChartSeries::ChartSeries(const QString &name, const QColor &color, float minimum, float maximum)
+    : m_name(name)
+    , m_color(color)
+    , m_minimum(minimum)
+    , m_maximum(maximum)
+{
+}
+
+void ChartSeries::append(qint64 time, float value)
+{
+    QMutexLocker locker(&m_mutex);
+    m_buffer.append(time, value);
+}
+
+void ChartSeries::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_buffer.clear();
+}
+
+void ChartSeries::envelope(qint64 from, qint64 to, int columns, QVector<float> &minimums, QVector<float> &maximums) const
+{
+    constexpr float none = std::numeric_limits<float>::quiet_NaN();
+    minimums.fill(none, columns);
+    maximums.fill(none, columns);
+    if (columns <= 0 || to <= from)
+        return;
+
+    const double scale = double(columns) / (to - from);
+    QMutexLocker locker(&m_mutex);
+    if (m_buffer.isEmpty())
+        return;
+
+    // Two points per column is all the detail a column can show
+    int level = m_buffer.levelFor(from, columns * 2);
+    m_buffer.forEach(level, from, [&](const DecimatingBuffer::Point &point) {
+        int column = qBound(0, int((point.time - from) * scale), columns - 1);
+        float &min = minimums[column];
+        float &max = maximums[column];
+        min = std::isnan(min) ? point.min : qMin(min, point.min);
+        max = std::isnan(max) ? point.max : qMax(max, point.max);
+    });
+}
+
+LiveChart::LiveChart(QWidget *parent) : QWidget(parent)
+{
+    setMinimumHeight(160);
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void LiveChart::addSeries(ChartSeries *series)
+{
+    m_series.append(series);
+}
+
+void LiveChart::setThresholds(const QVector<float> &thresholds)
+{
+    m_thresholds = thresholds;
+}
+
+void LiveChart::paintEvent(QPaintEvent *event)
+{
+    Q_UNUSED(event)
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::white);
+
+    const QRectF plot = QRectF(rect()).adjusted(8, 8, -8, -24);
+    const int columns = qMax(1, int(plot.width()));
+    const qint64 to = QDateTime::currentMSecsSinceEpoch();
+    const qint64 from = to - WINDOW;
+
+    // Grid, one vertical line a minute
+    painter.setPen(QPen(QColor("#e0e0e0"), 1));
+    for (int minute = 1; minute < WINDOW / 60000; ++minute) {
+        qreal x = plot.left() + plot.width() * minute * 60000 / WINDOW;
+        painter.drawLine(QPointF(x, plot.top()), QPointF(x, plot.bottom()));
+    }
+    painter.setPen(QPen(QColor("#9e9e9e"), 1));
+    painter.drawRect(plot);
+
+    if (!m_series.isEmpty()) {
+        const ChartSeries *first = m_series.first();
+        const QColor colors[] = {QColor("orange"), QColor("red")};
+        for (int i = 0; i < m_thresholds.size(); ++i) {
+            qreal y = plot.bottom() - plot.height() * (m_thresholds.at(i) - first->minimum()) / (first->maximum() - first->minimum());
+            painter.setPen(QPen(colors[qMin(i, 1)], 1, Qt::DashLine));
+            painter.drawLine(QPointF(plot.left(), y), QPointF(plot.right(), y));
+        }
+    }
+
+    painter.setRenderHint(QPainter::Antialiasing);
+    int legendX = int(plot.left());
+    for (const ChartSeries *series : std::as_const(m_series)) {
+        series->envelope(from, to, columns, m_minimums, m_maximums);
+        const float range = series->maximum() - series->minimum();
+        auto toY = [&](float value) {
+            return plot.bottom() - plot.height() * qBound(0.0f, (value - series->minimum()) / range, 1.0f);
+        };
+
+        // Zig-zag through min and max of every column: a line at low
+        // density, a filled envelope where samples are packed together
+        QPainterPath path;
+        bool drawing = false;
+        for (int column = 0; column < columns; ++column) {
+            if (std::isnan(m_minimums.at(column))) {
+                continue;
+            }
+            qreal x = plot.left() + column;
+            if (!drawing) {
+                path.moveTo(x, toY(m_maximums.at(column)));
+                drawing = true;
+            } else {
+                path.lineTo(x, toY(m_maximums.at(column)));
+            }
+            if (m_minimums.at(column) != m_maximums.at(column))
+                path.lineTo(x, toY(m_minimums.at(column)));
+        }
+        painter.setPen(QPen(series->color(), 2));
+        painter.drawPath(path);
+
+        QString legend = QString("%1 (%2-%3)").arg(series->name()).arg(series->minimum()).arg(series->maximum());
+        painter.drawText(QPoint(legendX, height() - 6), legend);
+        legendX += painter.fontMetrics().horizontalAdvance(legend) + 16;
+    }
+}
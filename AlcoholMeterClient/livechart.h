@@ -0,0 +1,62 @@
+#ifndef LIVECHART_H
+#define LIVECHART_H
+
+#include <QWidget>
+#include <QColor>
+#include <QMutex>
+#include <QString>
+#include "decimatingbuffer.h"
+
+// One plotted quantity. Samples may be appended from the decoder thread
+// while the chart paints on the UI thread.
+class ChartSeries
+{
+public:
+    ChartSeries(const QString &name, const QColor &color, float minimum, float maximum);
+
+    void append(qint64 time, float value);
+    void clear();
+
+    QString name() const { return m_name; }
+    QColor color() const { return m_color; }
+    float minimum() const { return m_minimum; }
+    float maximum() const { return m_maximum; }
+
+    // Min/max envelope since from, at most columns wide, as pixel columns
+    // of (min, max) pairs; NaN marks columns without data
+    void envelope(qint64 from, qint64 to, int columns, QVector<float> &minimums, QVector<float> &maximums) const;
+
+private:
+    mutable QMutex m_mutex;
+    DecimatingBuffer m_buffer;
+    QString m_name;
+    QColor m_color;
+    float m_minimum;
+    float m_maximum;
+};
+
+// Scrolling plot of the last WINDOW milliseconds of a few series, each on
+// its own fixed scale. The BAC bands are drawn as reference lines.
+class LiveChart : public QWidget
+{
+    Q_OBJECT
+
+public:
+    static constexpr qint64 WINDOW = 5 * 60 * 1000;
+
+    explicit LiveChart(QWidget *parent = nullptr);
+
+    void addSeries(ChartSeries *series);
+    void setThresholds(const QVector<float> &thresholds);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    QVector<ChartSeries*> m_series;
+    QVector<float> m_thresholds;    // In units of the first series
+    QVector<float> m_minimums;      // Scratch buffers reused between paints
+    QVector<float> m_maximums;
+};
+
+#endif // LIVECHART_H
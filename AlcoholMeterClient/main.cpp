@@ -5,6 +5,8 @@
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+    QCoreApplication::setOrganizationName("tbiliyor");
+    QCoreApplication::setApplicationName("AlcoholMeter");
     MainWindow w;
     w.show();
     return a.exec();
@@ -1,5 +1,6 @@
 
 #include "mainwindow.h"
+#include "tcpclient.h"
 #include <QRandomGenerator>
 #include <QWidget>
 #include <QHBoxLayout>
@@ -36,9 +37,9 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     measurementLayout->setAlignment(Qt::AlignCenter);
 
     // Value label
-    valueLabel = new QLabel(QString::number(bac, 'f', 2), this);
-    valueLabel->setStyleSheet("QLabel { font-size: 72px; font-weight: bold; color: green; }");
+    valueLabel = new QLabel(this);
     valueLabel->setAlignment(Qt::AlignCenter);
+    showBac(0.0f);
     measurementLayout->addWidget(valueLabel);
 
     // Unit label
@@ -49,6 +50,15 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     mainLayout->addWidget(measurementWidget);
 
+    // Breath curve of the last minutes, BAC against its bands and the raw sensor voltage
+    m_bacSeries = new ChartSeries("mg/L", QColor("#2196F3"), 0.0f, 2.0f);
+    m_voltSeries = new ChartSeries("V", QColor("#9e9e9e"), 0.0f, 4.096f);
+    chart = new LiveChart(this);
+    chart->addSeries(m_bacSeries);
+    chart->addSeries(m_voltSeries);
+    chart->setThresholds({0.3f, 0.5f});
+    mainLayout->addWidget(chart, 1);
+
     statusLabel = new QLabel("Status: Ready", this);
     statusLabel->setStyleSheet("QLabel { font-size: 24px; }");
     statusLabel->setAlignment(Qt::AlignCenter);
@@ -70,6 +80,15 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
         "QPushButton:pressed { background-color: #1565C0; }");
     mainLayout->addWidget(calibrateButton);
 
+    // Supervisor view of every meter in range
+    stationsButton = new QPushButton("Stations", this);
+    stationsButton->setStyleSheet(
+        "QPushButton { background-color: #607D8B; color: white; border-radius: 10px; "
+        "padding: 20px; min-width: 200px; font-size: 24px; }"
+        "QPushButton:hover { background-color: #546E7A; }"
+        "QPushButton:pressed { background-color: #455A64; }");
+    mainLayout->addWidget(stationsButton);
+
     exitButton = new QPushButton("Exit", this);
     exitButton->setStyleSheet(
         "QPushButton { background-color: #f44336; color: white; border-radius: 10px; "
@@ -80,6 +99,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     connect(startStopButton, &QPushButton::clicked, this, &MainWindow::toggleMeasurement);
     connect(calibrateButton, &QPushButton::clicked, this, &MainWindow::recalibrate);
+    connect(stationsButton, &QPushButton::clicked, this, &MainWindow::openDashboard);
     connect(exitButton, &QPushButton::clicked, this, &MainWindow::close);
 
 #if defined(Q_OS_ANDROID)
@@ -90,16 +110,62 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
     requestIOSBluetoothPermissions();
 #endif
 
-    m_bleConnection = new BluetoothClient();
-
-    connect(m_bleConnection, &BluetoothClient::statusChanged, this, &MainWindow::statusChanged);
-    connect(m_bleConnection, &BluetoothClient::changedState,this, &MainWindow::changedState);
-
-    m_bleConnection->startScan();
+    m_history = new HistorySync(this);
+    connect(m_history, &HistorySync::requestSync, this, [this](quint32 sequence) {
+        requestData<mSyncRequest>(sequence);
+    });
+    connect(m_history, &HistorySync::finished, this, [this](quint64 records) {
+        statusChanged(QString("History: %1 records").arg(records));
+    });
+    connect(m_history, &HistorySync::failed, this, &MainWindow::statusChanged);
+
+    // Frames are decoded off the UI thread, the widgets follow at REFRESH_INTERVAL
+    m_decoder = new FrameDecoder;
+    m_decoder->setSeries(m_bacSeries, m_voltSeries);
+    m_decoder->moveToThread(&m_decoderThread);
+    connect(&m_decoderThread, &QThread::finished, m_decoder, &QObject::deleteLater);
+    connect(m_decoder, &FrameDecoder::syncBatch, m_history, &HistorySync::handleBatch);
+    connect(m_decoder, &FrameDecoder::syncDone, m_history, &HistorySync::handleDone);
+    m_decoderThread.setObjectName("decoder");
+    m_decoderThread.start();
+
+    m_refreshTimer = new QTimer(this);
+    m_refreshTimer->setInterval(REFRESH_INTERVAL);
+    connect(m_refreshTimer, &QTimer::timeout, this, &MainWindow::refresh);
+
+    createTransport();
+    m_transport->start();
+    stationsButton->setVisible(m_bleConnection != nullptr);
 }
 
 MainWindow::~MainWindow()
 {
+    delete m_dashboard;
+    m_decoderThread.quit();
+    m_decoderThread.wait();
+    delete m_bacSeries;
+    delete m_voltSeries;
+}
+
+void MainWindow::createTransport()
+{
+    // ALCOHOLMETER_HOST=<host>[:port] talks to the device's local TCP endpoint instead of BLE
+    const QString hostValue = qEnvironmentVariable("ALCOHOLMETER_HOST");
+    if (!hostValue.isEmpty()) {
+        const QStringList parts = hostValue.split(':');
+        quint16 port = parts.size() > 1 ? parts.at(1).toUShort() : 0;
+        m_transport = new TcpClient(parts.at(0), port ? port : 5050, this);
+        connect(m_transport, &Transport::sendInfo, this, &MainWindow::statusChanged);
+    } else {
+        m_bleConnection = new BluetoothClient();
+        m_bleConnection->setParent(this);
+        connect(m_bleConnection, &BluetoothClient::statusChanged, this, &MainWindow::statusChanged);
+        connect(m_bleConnection, &BluetoothClient::changedState,this, &MainWindow::changedState);
+        m_transport = m_bleConnection;
+    }
+
+    connect(m_transport, &Transport::connectionState, this, &MainWindow::connectionStateChanged);
+    connect(m_transport, &Transport::dataReceived, m_decoder, &FrameDecoder::decode);
 }
 
 #if defined(Q_OS_ANDROID)
@@ -164,14 +230,14 @@ void MainWindow::requestAndroidPermissions()
 
 void MainWindow::recalibrate()
 {
-    if(!m_bleConnection->isConnected())
+    if(!m_transport->isConnected())
     {
         QMessageBox::warning(this, "Connection Error", "Device is not connected.\nPlease connect to device first.");
         return;
     }
 
     if (!isMeasuring) {
-        sendData(mCalibrate, 0);
+        sendData<mCalibrate>(0);
     } else {
         QMessageBox::warning(this, "Calibration", "Please stop measurements before calibrating.");
     }
@@ -179,7 +245,7 @@ void MainWindow::recalibrate()
 
 void MainWindow::toggleMeasurement()
 {
-    if(!m_bleConnection->isConnected())
+    if(!m_transport->isConnected())
     {
         QMessageBox::warning(this, "Connection Error", "Device is not connected.\nPlease connect to device first.");
         return;
@@ -198,7 +264,7 @@ void MainWindow::toggleMeasurement()
         statusLabel->setText("Status: Starting up... ");
         //startStopButton->setEnabled(false);
         calibrateButton->setEnabled(false);
-        sendData(mStart, 0);
+        sendData<mStart>(0);
         isMeasuring=true;
     } else {
         startStopButton->setText("Start");
@@ -211,56 +277,90 @@ void MainWindow::toggleMeasurement()
             "QPushButton:pressed { background-color: #398439; }"
             );
         statusLabel->setText("Status: Ready");
-        valueLabel->setText("0.00");
-        valueLabel->setStyleSheet("QLabel { font-size: 72px; font-weight: bold; color: green; }");
-        sendData(mStop, 0);
+        showBac(0.0f);
+        sendData<mStop>(0);
         isMeasuring=false;
     }
 }
 
-void MainWindow::updateMeasurement(float bac, float r0)
+void MainWindow::showBac(float bac)
 {
-    valueLabel->setText(QString::number(bac, 'f', 2));
-    if (bac < 0.3) {
+    const QString text = QString::number(bac, 'f', 2);
+    if (text != m_shownBac) {
+        m_shownBac = text;
+        valueLabel->setText(text);
+    }
+
+    // Re-parsing a stylesheet is expensive, only do it when the colour band changes
+    const BacBand band = bac < 0.3 ? BandLow : (bac < 0.5 ? BandWarning : BandHigh);
+    if (band == m_band)
+        return;
+
+    m_band = band;
+    if (band == BandLow) {
         valueLabel->setStyleSheet("QLabel { font-size: 72px; font-weight: bold; color: green; }");
-    } else if (bac < 0.5) {
+    } else if (band == BandWarning) {
         valueLabel->setStyleSheet("QLabel { font-size: 72px; font-weight: bold; color: orange; }");
     } else {
         valueLabel->setStyleSheet("QLabel { font-size: 72px; font-weight: bold; color: red; }");
     }
-    calibrationLabel->setText(QString("R0: %1").arg(QString::number(R0, 'f', 2)));
 }
 
-void MainWindow::statusChanged(const QString &status)
+void MainWindow::showR0(float r0)
 {
-    statusLabel->setText(status);
+    const QString text = QString("R0: %1").arg(QString::number(r0, 'f', 2));
+    if (text != m_shownR0) {
+        m_shownR0 = text;
+        calibrationLabel->setText(text);
+    }
 }
 
-void MainWindow::requestData(uint8_t command)
+void MainWindow::refresh()
 {
-    QByteArray payload;
-    QByteArray sendData = message.createMessage(command, mRead, payload);
-
-    // Verify message
-    if (sendData.isEmpty()) {
-        qWarning() << "Failed to create message for command:" << command;
+    const MeterState state = m_decoder->state();
+    if (state.revision == m_shownRevision)
         return;
+
+    m_shownRevision = state.revision;
+    chart->update();
+    showBac(state.bac);
+    showR0(state.r0);
+    if (state.statusRevision != m_shownStatusRevision) {
+        m_shownStatusRevision = state.statusRevision;
+        statusChanged(state.status);
     }
-    m_bleConnection->writeData(sendData);
 }
 
-void MainWindow::sendData(uint8_t command, float value)
+void MainWindow::openDashboard()
 {
-    QByteArray payload = Message::floatToBytes(value);
-    // Create message
-    QByteArray sendData = message.createMessage(command, mWrite, payload);
+    if (m_dashboard)
+        return;
+
+    // The dashboard connects to every meter itself, release ours meanwhile
+    m_transport->stop();
+    m_dashboard = new Dashboard;
+    connect(m_dashboard, &Dashboard::closed, this, [this]() {
+        m_dashboard = nullptr;
+        show();
+        m_transport->start();
+    });
+    hide();
+    m_dashboard->show();
+}
 
+void MainWindow::statusChanged(const QString &status)
+{
+    statusLabel->setText(status);
+}
+
+void MainWindow::writeFrame(const QByteArray &frame, uint8_t command)
+{
     // Verify message
-    if (sendData.isEmpty()) {
-        qWarning() << "Failed to create message for command:" << command;
+    if (frame.isEmpty()) {
+        qWarning() << "Failed to create message for command:" << Protocol::commandName(command);
         return;
     }
-    m_bleConnection->writeData(sendData);
+    m_transport->writeValue(frame);
 }
 
 void MainWindow::changedState(BluetoothClient::bluetoothleState state){
@@ -284,7 +384,6 @@ void MainWindow::changedState(BluetoothClient::bluetoothleState state){
     case BluetoothClient::Connected:
     {
         statusLabel->setText("Status: Ready");
-        connect(m_bleConnection, &BluetoothClient::newData, this, &MainWindow::dataHandler);
         break;
     }
     case BluetoothClient::DisConnected:
@@ -298,7 +397,6 @@ void MainWindow::changedState(BluetoothClient::bluetoothleState state){
     }
     case BluetoothClient::AcquireData:
     {
-        requestData(mR0);
         break;
     }
     case BluetoothClient::Error:
@@ -311,41 +409,18 @@ void MainWindow::changedState(BluetoothClient::bluetoothleState state){
     }
 }
 
-void MainWindow::dataHandler(QByteArray data)
+void MainWindow::connectionStateChanged(bool connected)
 {
-    uint8_t parsedCommand;
-    uint8_t rw;
-    QByteArray parsedValue;
-    auto parsed = message.parseMessage(&data, parsedCommand, parsedValue, rw);
-
-    if(!parsed)return;
-    float value = message.bytesToFloat(parsedValue);
-
-    if(rw == mWrite)
-    {
-        switch(parsedCommand)
-        {
-        case mR0:
-        {
-            R0 = value;
-            break;
-        }
-        case mCalcVal0:
-        {
-            bac = value;
-            break;
-        }
-        case mString:
-        {
-            QString strValue = QString::fromLocal8Bit(parsedValue).simplified();
-            statusChanged(strValue);
-            break;
-        }
-
-        default:
-            //nothing for now
-            break;
-        }
-        updateMeasurement(bac, R0);
+    if (connected) {
+        statusLabel->setText("Status: Ready");
+        m_refreshTimer->start();
+        requestData<mR0>();
+        // Pull whatever the device logged while we were away
+        m_history->setDevice(m_transport->peerId());
+        m_history->begin();
+    } else {
+        m_history->stop();
+        m_refreshTimer->stop();
+        statusChanged("Status: Disconnected");
     }
 }
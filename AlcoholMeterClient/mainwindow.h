@@ -6,9 +6,15 @@
 #include <QLabel>
 #include <QPushButton>
 #include <QVBoxLayout>
+#include <QThread>
 #include <QDebug>
 #include "bluetoothclient.h"
-#include "message.h"
+#include "transport.h"
+#include "historysync.h"
+#include "framedecoder.h"
+#include "livechart.h"
+#include "dashboard.h"
+#include "protocol.h"
 
 #if defined(Q_OS_ANDROID)
 #include <QJniObject>
@@ -23,6 +29,8 @@ class MainWindow : public QMainWindow
     Q_OBJECT
 
 public:
+    static constexpr int REFRESH_INTERVAL = 1000 / 30;   // UI repaint cap, ms
+
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
@@ -31,7 +39,9 @@ private slots:
     void recalibrate();
     void statusChanged(const QString &status);
     void changedState(BluetoothClient::bluetoothleState state);
-    void dataHandler(QByteArray data);
+    void connectionStateChanged(bool connected);
+    void refresh();
+    void openDashboard();
 
 private:
 
@@ -39,19 +49,46 @@ private:
     void requestAndroidPermissions();
 #endif
 
-    void updateMeasurement(float bac, float r0);
-    void requestData(uint8_t command);
-    void sendData(uint8_t command, float value);
+    enum BacBand { BandNone, BandLow, BandWarning, BandHigh };
+
+    void showBac(float bac);
+    void showR0(float r0);
+    template<uint8_t Command>
+    void requestData(const Protocol::ValueOf<Command, mRead> &value = {})
+    {
+        writeFrame(Protocol::encode<Command, mRead>(value), Command);
+    }
+
+    template<uint8_t Command>
+    void sendData(const Protocol::ValueOf<Command, mWrite> &value = {})
+    {
+        writeFrame(Protocol::encode<Command, mWrite>(value), Command);
+    }
+
+    void writeFrame(const QByteArray &frame, uint8_t command);
 
 #if defined(Q_OS_IOS)
     void requestIOSPermissions();
 #endif
 
+    void createTransport();
+
+    Transport *m_transport{nullptr};
     BluetoothClient *m_bleConnection{nullptr};
-    Message message;
+    HistorySync *m_history{nullptr};
+    FrameDecoder *m_decoder{nullptr};
+    ChartSeries *m_bacSeries{nullptr};
+    ChartSeries *m_voltSeries{nullptr};
+    QThread m_decoderThread;
+    QTimer *m_refreshTimer{nullptr};
+    Dashboard *m_dashboard{nullptr};
 
-    float R0 = 0.18f;
-    float bac = 0.0;
+    // What the widgets currently show, to skip redundant updates
+    quint64 m_shownRevision = 0;
+    quint64 m_shownStatusRevision = 0;
+    QString m_shownBac;
+    QString m_shownR0;
+    BacBand m_band = BandNone;
 
     // UI Elements
     QLabel *titleLabel;
@@ -59,8 +96,10 @@ private:
     QLabel* unitLabel;
     QLabel *statusLabel;
     QLabel *calibrationLabel;  // New label to show R0 value
+    LiveChart *chart;
     QPushButton *startStopButton;
     QPushButton *calibrateButton;  // New button for manual calibration
+    QPushButton *stationsButton;
     QPushButton *exitButton;
     bool isMeasuring{false};
 };
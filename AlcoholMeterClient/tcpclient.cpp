@@ -0,0 +1,106 @@
+#include "tcpclient.h"
+#include "message.h"
+#include <QDebug>
+
+TcpClient::TcpClient(const QString &host, quint16 port, QObject *parent)
+    : Transport(parent)
+    , m_host(host)
+    , m_port(port)
+{
+    m_socket = new QTcpSocket(this);
+    connect(m_socket, &QTcpSocket::connected, this, &TcpClient::onConnected);
+    connect(m_socket, &QTcpSocket::disconnected, this, &TcpClient::onDisconnected);
+    connect(m_socket, &QTcpSocket::readyRead, this, &TcpClient::onReadyRead);
+    connect(m_socket, &QTcpSocket::errorOccurred, this, &TcpClient::onErrorOccurred);
+
+    m_reconnectTimer = new QTimer(this);
+    m_reconnectTimer->setSingleShot(true);
+    m_reconnectTimer->setInterval(RECONNECT_INTERVAL);
+    connect(m_reconnectTimer, &QTimer::timeout, this, &TcpClient::start);
+}
+
+TcpClient::~TcpClient()
+{
+    stop();
+}
+
+void TcpClient::start()
+{
+    m_running = true;
+    if (m_socket->state() != QAbstractSocket::UnconnectedState)
+        return;
+
+    emit sendInfo(QString("Connecting to %1:%2").arg(m_host).arg(m_port));
+    m_socket->connectToHost(m_host, m_port);
+}
+
+void TcpClient::stop()
+{
+    m_running = false;
+    m_reconnectTimer->stop();
+    m_socket->disconnectFromHost();
+}
+
+void TcpClient::writeValue(const QByteArray &value)
+{
+    if (isConnected())
+        m_socket->write(value);
+}
+
+bool TcpClient::isConnected() const
+{
+    return m_socket->state() == QAbstractSocket::ConnectedState;
+}
+
+QString TcpClient::peerId() const
+{
+    return QString("tcp-%1-%2").arg(m_host).arg(m_port);
+}
+
+void TcpClient::onConnected()
+{
+    m_socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+    m_rxBuffer.clear();
+    emit sendInfo(QString("Connected to %1:%2").arg(m_host).arg(m_port));
+    emit connectionState(true);
+}
+
+void TcpClient::onDisconnected()
+{
+    emit connectionState(false);
+    if (m_running)
+        m_reconnectTimer->start();
+}
+
+void TcpClient::onReadyRead()
+{
+    m_rxBuffer.append(m_socket->readAll());
+
+    while (!m_rxBuffer.isEmpty()) {
+        int size = Message::frameSize(m_rxBuffer);
+        if (size == 0)
+            break;
+
+        if (size < 0) {
+            // Resynchronise on the next header byte
+            int next = m_rxBuffer.indexOf(static_cast<char>(mHeader), 1);
+            m_rxBuffer.remove(0, next < 0 ? m_rxBuffer.size() : next);
+            continue;
+        }
+
+        QByteArray frame = m_rxBuffer.left(size);
+        m_rxBuffer.remove(0, size);
+        emit dataReceived(frame);
+    }
+}
+
+void TcpClient::onErrorOccurred(QAbstractSocket::SocketError error)
+{
+    Q_UNUSED(error)
+    auto statusText = QString("Connection Error: %1").arg(m_socket->errorString());
+    qDebug() << statusText;
+    emit sendInfo(statusText);
+
+    if (m_running && m_socket->state() == QAbstractSocket::UnconnectedState)
+        m_reconnectTimer->start();
+}
@@ -0,0 +1,41 @@
+#ifndef TCPCLIENT_H
+#define TCPCLIENT_H
+
+#include <QTcpSocket>
+#include <QTimer>
+#include "transport.h"
+
+// Client side of the device's local telemetry endpoint. Splits the TCP
+// stream back into message.h frames and reconnects when the link drops.
+class TcpClient : public Transport
+{
+    Q_OBJECT
+
+public:
+    static constexpr int RECONNECT_INTERVAL = 2000;
+
+    TcpClient(const QString &host, quint16 port, QObject *parent = nullptr);
+    ~TcpClient();
+
+    void start() override;
+    void stop() override;
+    void writeValue(const QByteArray &value) override;
+    bool isConnected() const override;
+    QString peerId() const override;
+
+private slots:
+    void onConnected();
+    void onDisconnected();
+    void onReadyRead();
+    void onErrorOccurred(QAbstractSocket::SocketError error);
+
+private:
+    QTcpSocket *m_socket;
+    QTimer *m_reconnectTimer;
+    QString m_host;
+    quint16 m_port;
+    QByteArray m_rxBuffer;
+    bool m_running = false;
+};
+
+#endif // TCPCLIENT_H
@@ -0,0 +1,17 @@
+#ifndef ADCSOURCE_H
+#define ADCSOURCE_H
+
+// Source of raw ADC conversions. The daemon reads the ADS1115 through
+// wiringPi, benchmarks and tests replay recorded or synthetic traces.
+class AdcSource
+{
+public:
+    virtual ~AdcSource() = default;
+
+    virtual bool open() { return true; }
+
+    // Raw conversion of a channel, negative on a read error
+    virtual int read(int channel) = 0;
+};
+
+#endif // ADCSOURCE_H
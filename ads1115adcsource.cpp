@@ -0,0 +1,106 @@
+#include "ads1115adcsource.h"
+#include <QThread>
+
+Ads1115AdcSource::Ads1115AdcSource(I2cBus *bus, quint16 address, Gain gain, DataRate rate)
+    : m_bus(bus)
+    , m_address(address)
+    , m_gain(gain)
+    , m_rate(rate)
+{
+}
+
+Ads1115AdcSource::~Ads1115AdcSource()
+{
+    delete m_bus;
+}
+
+int Ads1115AdcSource::samplesPerSecond(DataRate rate)
+{
+    static const int rates[] = {8, 16, 32, 64, 128, 250, 475, 860};
+    return rates[rate];
+}
+
+std::chrono::microseconds Ads1115AdcSource::conversionPeriod(DataRate rate)
+{
+    return std::chrono::microseconds(1100000 / samplesPerSecond(rate));
+}
+
+bool Ads1115AdcSource::open()
+{
+    // Start converting channel 0 and check the device answers with our config
+    m_config = 0;
+    if (!writeConfig(configFor(0)))
+        return false;
+
+    quint16 config = 0;
+    return readRegister(REG_CONFIG, config) && (config & ~CONFIG_OS) == (m_config & ~CONFIG_OS);
+}
+
+int Ads1115AdcSource::read(int channel)
+{
+    if (channel < 0 || channel > 3)
+        return -1;
+
+    const quint16 config = configFor(channel);
+    if (config != m_config) {
+        if (!writeConfig(config))
+            return -1;
+        // The running conversion restarts with the new mux, wait for it
+        QThread::usleep(conversionPeriod(m_rate).count() + 50);
+    } else if (m_paced) {
+        // Any interval of one conversion period holds a finished conversion
+        const auto due = m_lastRead + conversionPeriod(m_rate);
+        const auto now = std::chrono::steady_clock::now();
+        if (now < due)
+            QThread::usleep(std::chrono::duration_cast<std::chrono::microseconds>(due - now).count() + 1);
+    }
+
+    quint16 value = 0;
+    if (!readRegister(REG_CONVERSION, value))
+        return -1;
+    m_lastRead = std::chrono::steady_clock::now();
+
+    // Single ended inputs can read slightly below ground
+    return qMax(0, static_cast<int>(static_cast<qint16>(value)));
+}
+
+void Ads1115AdcSource::setGain(Gain gain)
+{
+    m_gain = gain;      // Written with the next read
+}
+
+quint16 Ads1115AdcSource::configFor(int channel) const
+{
+    return ((CONFIG_MUX_SINGLE | channel) << CONFIG_MUX_SHIFT)
+           | (m_gain << CONFIG_PGA_SHIFT)
+           | (m_rate << CONFIG_DR_SHIFT)
+           | CONFIG_COMP_DISABLE;           // MODE 0, continuous
+}
+
+bool Ads1115AdcSource::writeConfig(quint16 config)
+{
+    quint8 data[3] = {REG_CONFIG, static_cast<quint8>(config >> 8), static_cast<quint8>(config & 0xff)};
+    I2cMessage message{m_address, false, data, sizeof(data)};
+    if (!m_bus->transfer(&message, 1)) {
+        m_config = 0;
+        return false;
+    }
+    m_config = config;
+    return true;
+}
+
+bool Ads1115AdcSource::readRegister(quint8 reg, quint16 &value)
+{
+    // Pointer write and result read with a repeated start, one transaction
+    quint8 pointer = reg;
+    quint8 data[2] = {0, 0};
+    I2cMessage messages[2] = {
+        {m_address, false, &pointer, 1},
+        {m_address, true, data, sizeof(data)},
+    };
+    if (!m_bus->transfer(messages, 2))
+        return false;
+
+    value = static_cast<quint16>((data[0] << 8) | data[1]);
+    return true;
+}
@@ -0,0 +1,67 @@
+#ifndef ADS1115ADCSOURCE_H
+#define ADS1115ADCSOURCE_H
+
+#include "adcsource.h"
+#include "i2cbus.h"
+#include <chrono>
+
+// Native ADS1115 driver on an I2cBus. The converter runs in continuous
+// mode and the config register is cached, so the config is only written
+// when the channel (mux) or gain changes; every other sample is one
+// combined pointer-write/result-read transaction. Reads are spaced at
+// least one conversion period apart, an earlier one would return the same
+// conversion again.
+class Ads1115AdcSource : public AdcSource
+{
+public:
+    static constexpr quint16 DEFAULT_ADDRESS = 0x48;
+
+    // Register pointers
+    static constexpr quint8 REG_CONVERSION = 0x00;
+    static constexpr quint8 REG_CONFIG = 0x01;
+
+    // Config register fields
+    static constexpr quint16 CONFIG_OS = 0x8000;
+    static constexpr int CONFIG_MUX_SHIFT = 12;
+    static constexpr quint16 CONFIG_MUX_SINGLE = 0x4;        // AINx against GND, x in the low bits
+    static constexpr int CONFIG_PGA_SHIFT = 9;
+    static constexpr quint16 CONFIG_MODE_SINGLE = 0x0100;
+    static constexpr int CONFIG_DR_SHIFT = 5;
+    static constexpr quint16 CONFIG_COMP_DISABLE = 0x0003;
+
+    enum Gain { Gain6144 = 0, Gain4096, Gain2048, Gain1024, Gain512, Gain256 };
+    enum DataRate { Sps8 = 0, Sps16, Sps32, Sps64, Sps128, Sps250, Sps475, Sps860 };
+
+    // Takes ownership of the bus. ±4.096 V matches MeasurementPipeline.
+    explicit Ads1115AdcSource(I2cBus *bus, quint16 address = DEFAULT_ADDRESS,
+                              Gain gain = Gain4096, DataRate rate = Sps860);
+    ~Ads1115AdcSource();
+
+    bool open() override;
+    int read(int channel) override;
+
+    void setGain(Gain gain);
+    // Off for emulated converters, which have a new result on every read
+    void setPaced(bool paced) { m_paced = paced; }
+    quint16 config() const { return m_config; }
+    I2cBus *bus() const { return m_bus; }
+
+    static int samplesPerSecond(DataRate rate);
+    // Longest time between two conversions, the oscillator is within 10%
+    static std::chrono::microseconds conversionPeriod(DataRate rate);
+
+private:
+    quint16 configFor(int channel) const;
+    bool writeConfig(quint16 config);
+    bool readRegister(quint8 reg, quint16 &value);
+
+    I2cBus *m_bus;
+    quint16 m_address;
+    Gain m_gain;
+    DataRate m_rate;
+    quint16 m_config = 0;       // Last config written, 0 before the first write
+    bool m_paced = true;
+    std::chrono::steady_clock::time_point m_lastRead;
+};
+
+#endif // ADS1115ADCSOURCE_H
@@ -1,34 +1,53 @@
 // alcoholmeter.cpp
 #include "alcoholmeter.h"
+#include "logger.h"
+#include "metrics.h"
+#include "wiringpiadcsource.h"
+#include "ads1115adcsource.h"
+#include "gpiodeventsource.h"
 #include <QDebug>
 #include <QThread>
+#include <QFutureWatcher>
 #include <QRandomGenerator>
+#include <QtConcurrent>
+#include <algorithm>
 
 #include <wiringPi.h>
-#include <wiringPiI2C.h>
-#include <ads1115.h>
 
-#define PINBASE 120
-#define ADS_ADDR 0x48
+// The ADS1115 through i2c-dev, ALCOHOLMETER_ADC=wiringpi selects the wiringPi extension
+static AdcSource *createAdcSource()
+{
+    if (qEnvironmentVariable("ALCOHOLMETER_ADC") == "wiringpi")
+        return new WiringPiAdcSource;
+
+    auto *bus = new I2cDevBus(qEnvironmentVariable("ALCOHOLMETER_I2C_BUS", "/dev/i2c-1"));
+    bus->open();
+    return new Ads1115AdcSource(bus, WiringPiAdcSource::ADS_ADDR);
+}
+
+// ALCOHOLMETER_DECIMATOR=boxcar|fir|cic and ALCOHOLMETER_MAINS=50|60|0 (no notch)
+static Decimator::Config decimatorConfig()
+{
+    Decimator::Config config;
+    QString type = qEnvironmentVariable("ALCOHOLMETER_DECIMATOR", "fir");
+    if (!Decimator::parseType(type, config.type))
+        qWarning() << "Unknown decimator" << type << "- using fir";
+    bool ok = false;
+    int mains = qEnvironmentVariableIntValue("ALCOHOLMETER_MAINS", &ok);
+    if (ok)
+        config.notch = mains;
+    return config;
+}
 
 AlcoholMeter::AlcoholMeter(QObject *parent)
     : QObject(parent)
     , isMeasuring(false)
-    , warmupCount(WARMUP_TIME)
+    , warmupCount(0)
 {
-
-    gattServer = GattServer::getInstance();
-    if (gattServer)
-    {
-        qDebug() << "Starting gatt service";
-        QObject::connect(gattServer, &GattServer::connectionState, this, &AlcoholMeter::onConnectionStatedChanged);
-        QObject::connect(gattServer, &GattServer::dataReceived, this, &AlcoholMeter::onDataReceived);
-        gattServer->startBleService();
-    }
+    startupTracker = new StartupTracker(this);
 
     // Initialize timers
     measurementTimer = new QTimer(this);
-    measurementTimer->setInterval(MEASUREMENT_INTERVAL);
 
     warmupTimer = new QTimer(this);
     warmupTimer->setInterval(1000);
@@ -37,36 +56,188 @@ AlcoholMeter::AlcoholMeter(QObject *parent)
     connect(measurementTimer, &QTimer::timeout, this, &AlcoholMeter::updateMeasurement);
     connect(warmupTimer, &QTimer::timeout, this, &AlcoholMeter::updateWarmup);
 
-    if (wiringPiSetupGpio() == -1) {
-        qCritical() << "Failed to initialize GPIO! Check permissions and hardware connection.";
+    releaseTimer = new QTimer(this);
+    releaseTimer->setSingleShot(true);
+    releaseTimer->setInterval(ARMED_RELEASE_DELAY);
+    connect(releaseTimer, &QTimer::timeout, this, &AlcoholMeter::arm);
+
+    // Tuning values, ALCOHOLMETER_CONFIG overrides the file. Edits to it and
+    // mParam writes take effect without a restart.
+    parameters = new ParameterRegistry(qEnvironmentVariable("ALCOHOLMETER_CONFIG", "alcoholmeter.ini"), this);
+    parameters->load();
+    applyParameters(parameters->current());
+    connect(parameters, &ParameterRegistry::changed, this, &AlcoholMeter::applyParameters);
+
+    // Binary audit trail of every reading, ALCOHOLMETER_LOG_DIR overrides the location
+    QString logDirectory = qEnvironmentVariable("ALCOHOLMETER_LOG_DIR", "sessions");
+    measurementLog = new MeasurementLog(logDirectory, this);
+    if (measurementLog->open()) {
+        sessionStore = new SessionStore(logDirectory, this);
+    } else {
+        delete measurementLog;
+        measurementLog = nullptr;
+    }
+
+    // R0, baseline and Kalman state of the last run, ALCOHOLMETER_STATE_FILE overrides the location
+    calibrationStore = new CalibrationStore(qEnvironmentVariable("ALCOHOLMETER_STATE_FILE", "alcoholmeter.state"));
+    stateTimer = new QTimer(this);
+    stateTimer->setInterval(STATE_SAVE_INTERVAL);
+    connect(stateTimer, &QTimer::timeout, this, &AlcoholMeter::saveState);
+
+    streamTimer = new QTimer(this);
+    streamTimer->setInterval(STREAM_INTERVAL);
+    connect(streamTimer, &QTimer::timeout, this, &AlcoholMeter::streamRecords);
+
+    // GPIO and ADC set-up and the state file run on the thread pool while the
+    // event loop brings up BLE. Calibration follows once both are in.
+    startupTracker->begin(StartupTracker::Hardware);
+    startupTracker->begin(StartupTracker::StateRestore);
+    startupTracker->begin(StartupTracker::Calibration);
+
+    auto *stateWatcher = new QFutureWatcher<bool>(this);
+    connect(stateWatcher, &QFutureWatcher<bool>::finished, this, [this, stateWatcher]() {
+        onStateRestored(stateWatcher->result());
+        stateWatcher->deleteLater();
+    });
+    CalibrationStore *store = calibrationStore;
+    stateRestore = QtConcurrent::run([store]() {
+        return store->load(QDateTime::currentMSecsSinceEpoch());
+    });
+    stateWatcher->setFuture(stateRestore);
+
+    auto *hardwareWatcher = new QFutureWatcher<AdcSource*>(this);
+    connect(hardwareWatcher, &QFutureWatcher<AdcSource*>::finished, this, [this, hardwareWatcher]() {
+        onHardwareReady(hardwareWatcher->result());
+        hardwareWatcher->deleteLater();
+    });
+    hardwareInit = QtConcurrent::run([]() -> AdcSource* {
+        if (wiringPiSetupGpio() == -1) {
+            qCritical() << "Failed to initialize GPIO! Check permissions and hardware connection.";
+            return nullptr;
+        }
+
+        AdcSource *source = createAdcSource();
+        if (!source->open())
+            qCritical() << "Failed to set up the ADS1115.";
+
+        QThread::msleep(500);
+
+        pinMode(MQ3_POWER_PIN, OUTPUT);
+        digitalWrite(MQ3_POWER_PIN, LOW);
+        return source;
+    });
+    hardwareWatcher->setFuture(hardwareInit);
+}
+
+void AlcoholMeter::onHardwareReady(AdcSource *source)
+{
+    adcSource = source;
+    if (!adcSource) {
+        startupTracker->finish(StartupTracker::Hardware, false);
+        startupTracker->finish(StartupTracker::Calibration, false);
+        sendString(QString("Status: Start-up failed"));
         return;
     }
 
-    ads1115Setup(PINBASE, ADS_ADDR);
+    pipeline.setSource(adcSource);
+    pipeline.setDecimator(decimatorConfig());
+    // Hampel window in samples, ALCOHOLMETER_HAMPEL_WINDOW=0 turns outlier rejection off
+    bool windowSet = false;
+    int hampelWindow = qEnvironmentVariableIntValue("ALCOHOLMETER_HAMPEL_WINDOW", &windowSet);
+    if (windowSet)
+        pipeline.setOutlierWindow(hampelWindow);
+
+    // D0 comparator edges instead of polling, ALCOHOLMETER_GPIO_CHIP selects the chip
+    gpioEvents = new GpiodEventSource(qEnvironmentVariable("ALCOHOLMETER_GPIO_CHIP", "gpiochip0"), this);
+    connect(gpioEvents, &GpioEventSource::edge, this, &AlcoholMeter::onGpioEdge);
+    if (gpioEvents->watch(MQ3_STATUS_PIN))
+        alcoholPresent = gpioEvents->value(MQ3_STATUS_PIN) != MQ3_STATUS_ACTIVE_LOW;
+
+    startupTracker->finish(StartupTracker::Hardware);
+    finishStartup();
+}
+
+void AlcoholMeter::onStateRestored(bool restored)
+{
+    stateRestored = restored;
+    startupTracker->finish(StartupTracker::StateRestore);
+    finishStartup();
+}
 
-    QThread::msleep(500);
+void AlcoholMeter::finishStartup()
+{
+    if (started || !adcSource || !startupTracker->isFinished(StartupTracker::StateRestore))
+        return;
 
-    pinMode(MQ3_POWER_PIN, OUTPUT);
-    digitalWrite(MQ3_POWER_PIN, LOW);
+    started = true;
+    // A recent calibration is reused, a warm sensor would bias a new one
+    if (stateRestored) {
+        R0 = calibrationStore->r0();
+        LOG_INFO(logMeter, "Restored R0 %.4f, no calibration needed", R0);
+        startupTracker->finish(StartupTracker::Calibration);
+    } else {
+        R0 = calibrateSensor();
+    }
+    if (calibrationStore->hasFilterState())
+        pipeline.restoreFilter(calibrationStore->filterState());
+    send<mR0>(R0);
 
-    // Initial calibration
-    R0 = calibrateSensor();
-    sendData(mR0, R0);   
+    // Battery kiosks wait armed between subjects, enable with ALCOHOLMETER_ARMED_IDLE=1
+    setArmedIdle(qEnvironmentVariableIntValue("ALCOHOLMETER_ARMED_IDLE") != 0);
+}
+
+bool AlcoholMeter::isStarting()
+{
+    if (started)
+        return false;
+
+    // A failed start is final, clients must not keep waiting for it
+    sendString(startupTracker->hasFailed() ? QString("Status: Start-up failed") : QString("Status: Starting"));
+    return true;
 }
 
 AlcoholMeter::~AlcoholMeter()
 {
+    // Start-up tasks still running use the store and the GPIO
+    stateRestore.waitForFinished();
+    hardwareInit.waitForFinished();
+    if (!adcSource && hardwareInit.isValid())
+        adcSource = hardwareInit.result();
+
+    // Never leave the heater on behind us
+    armedIdle = false;
     stopMeasurement();
-    if (gattServer)
+    saveState();
+    if (armed)
+        safePowerDown();
+    for (Transport *transport : std::as_const(transports))
     {
-        gattServer->stopBleService();
-        delete gattServer;
+        transport->stop();
     }
+    delete adcSource;
+    delete calibrationStore;
+}
+
+void AlcoholMeter::addTransport(Transport *transport)
+{
+    if (!transport || transports.contains(transport))
+        return;
+
+    // Transports without an owner are owned by the meter
+    if (!transport->parent())
+        transport->setParent(this);
+
+    transports.append(transport);
+    QObject::connect(transport, &Transport::connectionState, this, &AlcoholMeter::onConnectionStatedChanged);
+    QObject::connect(transport, &Transport::dataReceived, this, &AlcoholMeter::onDataReceived);
+    transport->start();
 }
 
 void AlcoholMeter::startMeasurement()
 {
-    if (!isMeasuring) {
+    if (armed) {
+        wake();
+    } else if (!isMeasuring) {
         toggleMeasurement();
     }
 }
@@ -85,8 +256,7 @@ float AlcoholMeter::getCurrentR0() const
 
 int AlcoholMeter::readADC(int addr)
 {
-    int rawValue = analogRead(PINBASE + addr);
-    return (rawValue < 0) ? 0 : rawValue;  // Prevent negative readings
+    return pipeline.readSample(addr);
 }
 
 float AlcoholMeter::calibrateSensor()
@@ -99,23 +269,23 @@ float AlcoholMeter::calibrateSensor()
     QTimer* timer = new QTimer(this);
     timer->setSingleShot(true);
     connect(timer, &QTimer::timeout, this, [this, timer]() {
-        float sensorValue = 0;
         // Get average reading
-        for(int x = 0; x < READ_SAMPLES; x++) {
-            sensorValue += readADC(0);
-            QThread::msleep(10);
-        }
-        sensorValue = sensorValue / READ_SAMPLES;
-        float sensor_volt = (sensorValue / VOLT_RESOLUTION) * ADS1115_VOLTAGE_RANGE;
-        float RS_air = 0.0f;
-        if(sensor_volt > 0)
-        {
-            RS_air = (SENSOR_VCC - sensor_volt) / sensor_volt;
-            R0 = RS_air / CLEAN_AIR_FACTOR;
+        float sensorValue = pipeline.acquire(params.readSamples, ParameterRegistry::calibrationInterval(params));
+        reportFault();
+        float cleanAirR0 = MeasurementPipeline::cleanAirR0(sensorValue);
+        if (pipeline.usable() && cleanAirR0 > 0) {
+            R0 = cleanAirR0;
+            if (!calibrationStore->addCalibration(R0, QDateTime::currentMSecsSinceEpoch()))
+                qWarning() << "R0" << R0 << "is far from the baseline" << calibrationStore->baselineMedian();
+            saveState();
         }
+        // A failed calibration keeps the previous R0, the fault report tells the client
+        startupTracker->finish(StartupTracker::Calibration);
 
-        safePowerDown();
-        QString msg = QString("Status: Ready").simplified();
+        // Armed idle and measurements keep the heater warm
+        if (!armed && !isMeasuring)
+            safePowerDown();
+        QString msg = QString(armed ? "Status: Armed" : "Status: Ready").simplified();
         qDebug().noquote() << msg;
         sendString(msg);
         timer->deleteLater();
@@ -126,19 +296,27 @@ float AlcoholMeter::calibrateSensor()
 
 void AlcoholMeter::safePowerUp() {
     setPinHigh(MQ3_POWER_PIN);
+    if (!heaterTimer.isValid())
+        heaterTimer.start();
 }
 
 void AlcoholMeter::safePowerDown() {
     setPinLow(MQ3_POWER_PIN);
+    heaterTimer.invalidate();
 }
 void AlcoholMeter::toggleMeasurement()
 {
     isMeasuring = !isMeasuring;
 
     if (isMeasuring) {
+        armed = false;
         safePowerUp();
-        warmupCount = WARMUP_TIME;
+        warmupCount = remainingWarmup();
         qDebug() << "Starting measurement...";
+        if (warmupCount == 0) {
+            beginMeasuring();
+            return;
+        }
         QString msg = QString("Warming up... %1s").arg(warmupCount).simplified();
         qDebug().noquote() << msg;
         sendString(msg);
@@ -146,8 +324,15 @@ void AlcoholMeter::toggleMeasurement()
     } else {
         warmupTimer->stop();
         measurementTimer->stop();
-        safePowerDown();
+        releaseTimer->stop();
+        stateTimer->stop();
+        saveState();
         qDebug() << "Measurement stopped.";
+        if (armedIdle) {
+            arm();
+            return;
+        }
+        safePowerDown();
         QString msg = QString("Status: Ready").simplified();
         qDebug().noquote() << msg;
         sendString(msg);
@@ -159,148 +344,395 @@ void AlcoholMeter::updateWarmup()
     warmupCount--;
     if (warmupCount > 0) {
         QString msg = QString("Warming up... %1s").arg(warmupCount).simplified();
-        qDebug().noquote() << msg;
+        LOG_INFO(logMeter, "Warming up... %.0fs", warmupCount);
         sendString(msg);
     } else {
         warmupTimer->stop();
-        measurementTimer->start();
-        QString msg = QString("Status: Measuring").simplified();
-        qDebug().noquote() << msg;
-        sendString(msg);
+        beginMeasuring();
+    }
+}
+
+void AlcoholMeter::beginMeasuring()
+{
+    p_start = QDateTime::currentDateTime();
+    measurementTimer->start();
+    stateTimer->start();
+    if (armedIdle && !alcoholPresent)
+        releaseTimer->start();
+    QString msg = QString("Status: Measuring").simplified();
+    LOG_INFO(logMeter, "Status: Measuring");
+    sendString(msg);
+}
+
+int AlcoholMeter::remainingWarmup() const
+{
+    if (!heaterTimer.isValid())
+        return params.warmupTime;
+    return static_cast<int>(qMax<qint64>(0, params.warmupTime - heaterTimer.elapsed() / 1000));
+}
+
+void AlcoholMeter::arm()
+{
+    if (isMeasuring) {
+        isMeasuring = false;
+        warmupTimer->stop();
+        measurementTimer->stop();
+        stateTimer->stop();
+        saveState();
     }
+    releaseTimer->stop();
+    safePowerUp();
+    if (armed)
+        return;
+
+    armed = true;
+    LOG_INFO(logMeter, "Status: Armed");
+    sendString(QString("Status: Armed"));
+}
+
+void AlcoholMeter::setArmedIdle(bool enabled)
+{
+    armedIdle = enabled;
+    if (armedIdle && !isMeasuring)
+        arm();
+}
+
+void AlcoholMeter::wake()
+{
+    if (!armed)
+        return;
+
+    LOG_INFO(logMeter, "Woken from armed idle");
+    toggleMeasurement();
+    // The heater is warm, take the first reading now
+    queueReading();
+}
+
+void AlcoholMeter::queueReading()
+{
+    // A reading blocks for the whole acquisition, take it from the event
+    // loop and only once however many requests arrive meanwhile
+    if (readingQueued)
+        return;
+
+    readingQueued = true;
+    QTimer::singleShot(0, this, [this]() {
+        readingQueued = false;
+        if (!measurementTimer->isActive())
+            return;
+        // The next periodic reading is one interval after this one
+        measurementTimer->start();
+        updateMeasurement();
+    });
 }
 
 void AlcoholMeter::updateMeasurement()
 {
-    float sensorValue = 0;
     p_end = QDateTime::currentDateTime();
     qint64 elapsedTimeMillis = p_start.msecsTo(p_end);
 
     // Get average reading
-    for(int x = 0; x < READ_SAMPLES; x++) {
-        sensorValue += readADC(0);
-        QThread::msleep(2);
-    }
-    sensorValue = sensorValue / READ_SAMPLES;
+    float sensorValue = pipeline.acquire(params.readSamples, params.sampleInterval);
+
+    // A faulty block leaves the Kalman state alone, the next good one
+    // integrates over the whole gap
+    reportFault();
+    if (!pipeline.usable())
+        return;
 
     p_dt = elapsedTimeMillis / 1000.0;
-    if (p_dt > 0) {
-        kalmanBac.Update(sensorValue, measurementVariance, p_dt);
-        sensorValue = kalmanBac.GetXAbs();
-    } else {
-        qDebug() << "Warning: Time delta too small, skipping Kalman update";
+    if (p_dt <= 0)
+        LOG_WARNING(logMeter, "Time delta too small, skipping Kalman update");
+
+    Measurement measurement = pipeline.process(sensorValue, p_dt, R0);
+    if (!measurement.valid) {
+        LOG_WARNING(logMeter, "No valid reading at %.3f V, not sent", measurement.volt);
+        p_start = p_end;
+        return;
     }
+    bac = measurement.bac;
+
+    send<mCalcVal0>(bac);
+    send<mAdc0>(measurement.volt);
+
+    if (measurementLog)
+        measurementLog->append(p_end.toMSecsSinceEpoch(), measurement.raw, measurement.filtered, bac, R0);
 
-    // Calculate sensor voltage
-    float sensor_volt = (sensorValue / VOLT_RESOLUTION) * ADS1115_VOLTAGE_RANGE;
+    LOG_INFO(logMeter, "ADC: %.1f V: %.3f RS/R0: %.3f BAC: %.3f mg/L", measurement.filtered, measurement.volt, measurement.ratio, bac);
+
+    Metrics::instance().markReading();
+    startupTracker->markFirstReading();
+    emit measurementUpdated(bac);
+    p_start = p_end;
+}
 
-    // Calculate RS
-    float RS = (SENSOR_VCC - sensor_volt) / sensor_volt;
+void AlcoholMeter::applyParameters(const Parameters &parameters)
+{
+    params = parameters;
+    pipeline.setVariances(params.accelVariance, params.measurementVariance);
+    // Restarts a running timer, the next reading is one new interval away
+    measurementTimer->setInterval(params.measurementInterval);
+    LOG_INFO(logMeter, "Parameters: %.0f samples every %.0f ms, reading every %.0f ms",
+             params.readSamples, params.sampleInterval, params.measurementInterval);
+}
 
-    // Calculate ratio RS/R0
-    float rs_ro_ratio = RS / R0;
+void AlcoholMeter::saveState()
+{
+    // Nothing calibrated or restored yet, keep whatever is on disk
+    if (!calibrationStore || calibrationStore->r0() <= 0)
+        return;
 
-    // Convert to mg/L based on datasheet curve
+    calibrationStore->setFilterState(pipeline.filterState());
+    calibrationStore->save(QDateTime::currentMSecsSinceEpoch());
+}
 
-    if (rs_ro_ratio > 20.0f) {
-        bac = 0.1f * (20.0f / rs_ro_ratio);
-    } else if (rs_ro_ratio < 3.0f) {
-        bac = 1.0f * (3.0f / rs_ro_ratio);
+void AlcoholMeter::reportFault()
+{
+    const SensorFault &fault = pipeline.fault();
+    if (fault.kind == lastFault)
+        return;
+
+    lastFault = fault.kind;
+    if (fault.kind == SensorFault::None) {
+        LOG_INFO(logMeter, "Sensor fault cleared");
     } else {
-        // Linear interpolation between 0.1 and 1.0 mg/L
-        bac = 0.1f + (20.0f - rs_ro_ratio) * (0.9f / 17.0f);
+        qWarning().noquote() << "Sensor fault:" << sensorFaultName(fault.kind) << "in" << fault.faulty
+                             << "of" << fault.samples << "samples, last raw" << fault.value;
+    }
+    send<mFault>(fault);
+}
+
+void AlcoholMeter::sendString(QString value)
+{
+    send<mString>(value.toLocal8Bit());
+}
+
+void AlcoholMeter::publish(const QByteArray &frame, const ReplyTarget &target)
+{
+    StageTimer timer(Metrics::instance().stage(MetricsSummary::Send));
+    if (target.transport) {
+        target.transport->writeTo(target.peer, frame);
+        return;
+    }
+    for (Transport *transport : std::as_const(transports))
+    {
+        transport->writeValue(frame);
     }
+}
+
+void AlcoholMeter::queryRange(const Protocol::TimeRange &range, uint8_t id, const ReplyTarget &requester)
+{
+    const qint64 from = range.from;
+    const qint64 to = range.to;
 
-    sendData(mCalcVal0, bac);
-    sendData(mAdc0, sensor_volt);
+    // One query at a time, a newer one ends the one still streaming
+    if (queryStreaming) {
+        queryStreaming = false;
+        send<mQueryDone>(streamedRecords, streamId, streamTarget);
+    }
 
-    qDebug() << "Raw ADC Value:" << sensorValue;
-    qDebug() << "Sensor Voltage:" << sensor_volt << "V";
-    qDebug() << "RS:" << RS;
-    qDebug() << "RS/R0 ratio:" << rs_ro_ratio;
-    qDebug() << "BAC:" << bac << "mg/L";
+    streamedRecords = 0;
+    streamTarget = requester;
+    streamId = id;
+    if (!sessionStore || from > to) {
+        send<mQueryDone>(0, streamId, streamTarget);
+        return;
+    }
 
-    emit measurementUpdated(bac);
-    p_start = p_end;
+    // Make everything logged so far visible to the mapped segments
+    measurementLog->flush();
+    sessionStore->refresh();
+    streamCursor = sessionStore->rangeCursor(from, to);
+    queryStreaming = true;
+    if (!streamTimer->isActive())
+        streamTimer->start();
+    streamRecords();
 }
 
-void AlcoholMeter::sendData(uint8_t command, float value)
+void AlcoholMeter::syncHistory(quint32 sequence, uint8_t id, const ReplyTarget &requester)
 {
-    QByteArray payload = Message::floatToBytes(value);
-    QByteArray sendData = message.createMessage(command, mWrite, payload);
+    // A repeated request replaces the batch still being sent
+    syncData.clear();
+    syncHeader = SyncChunkHeader{};
 
-    if (sendData.isEmpty()) {
-        qWarning() << "Failed to create message for command:" << command;
+    if (!sessionStore) {
+        send<mSyncDone>(Protocol::SyncState{0, 0}, id, requester);
         return;
     }
-    gattServer->writeValue(sendData);
+
+    // Only touch the log files when the client has caught up with what is mapped
+    const bool refreshed = sequence >= sessionStore->endSequence();
+    if (refreshed) {
+        measurementLog->flush();
+        sessionStore->refresh();
+    }
+
+    // One batch per request: the client asks for the next one once this is stored,
+    // and a request repeated after a reconnect restarts from its high-water mark
+    SessionStore::Cursor cursor = sessionStore->sequenceCursor(sequence);
+    constexpr int batchBytes = SYNC_BATCH_RECORDS * sizeof(LogRecord);
+    QByteArray batch;
+    batch.reserve(batchBytes);
+    while (batch.size() < batchBytes) {
+        QByteArray records = sessionStore->next(cursor, (batchBytes - batch.size()) / sizeof(LogRecord));
+        if (records.isEmpty())
+            break;
+        batch.append(records);
+    }
+
+    if (batch.isEmpty()) {
+        send<mSyncDone>(syncState(), id, requester);
+        return;
+    }
+
+    // The chunks go out in bursts like query records, a whole batch at once
+    // would overrun the notification queue of the BLE stack
+    syncData = qCompress(batch);
+    syncHeader.epoch = measurementLog->epoch();
+    syncHeader.firstSequence = reinterpret_cast<const LogRecord*>(batch.constData())->sequence;
+    syncHeader.recordCount = batch.size() / sizeof(LogRecord);
+    syncHeader.chunkCount = (syncData.size() + SYNC_CHUNK_SIZE - 1) / SYNC_CHUNK_SIZE;
+    // Without a refresh the next request picks up what was logged meanwhile
+    syncComplete = refreshed && sessionStore->next(cursor, 1).isEmpty();
+    syncTarget = requester;
+    syncId = id;
+    if (!streamTimer->isActive())
+        streamTimer->start();
+    streamRecords();
 }
 
-void AlcoholMeter::sendString(QString value)
+Protocol::SyncState AlcoholMeter::syncState() const
+{
+    // The epoch lets a client tell a log started over from one it already holds
+    return Protocol::SyncState{sessionStore->endSequence(), measurementLog->epoch()};
+}
+
+void AlcoholMeter::streamRecords()
 {
-    QByteArray bytedata;
-    bytedata = value.toLocal8Bit();
-    QByteArray sendData = message.createMessage(mString, mWrite, bytedata);
-    gattServer->writeValue(sendData);
+    // A running query and a sync batch share the frames of a burst
+    int frames = 0;
+    for (; frames < FRAMES_PER_BURST && queryStreaming; frames++) {
+        QByteArray records = sessionStore->next(streamCursor, RECORDS_PER_FRAME);
+        if (records.isEmpty()) {
+            queryStreaming = false;
+            send<mQueryDone>(streamedRecords, streamId, streamTarget);
+            break;
+        }
+
+        send<mRecords>(records, streamId, streamTarget);
+        streamedRecords += records.size() / sizeof(LogRecord);
+    }
+
+    for (; frames < FRAMES_PER_BURST && !syncData.isEmpty(); frames++) {
+        const int offset = syncHeader.chunkIndex * SYNC_CHUNK_SIZE;
+        QByteArray chunkPayload(reinterpret_cast<const char*>(&syncHeader), sizeof(syncHeader));
+        chunkPayload.append(syncData.constData() + offset, qMin(SYNC_CHUNK_SIZE, syncData.size() - offset));
+        send<mSyncBatch>(chunkPayload, syncId, syncTarget);
+
+        if (++syncHeader.chunkIndex == syncHeader.chunkCount) {
+            syncData.clear();
+            if (syncComplete)
+                send<mSyncDone>(syncState(), syncId, syncTarget);
+        }
+    }
+
+    if (!queryStreaming && syncData.isEmpty())
+        streamTimer->stop();
 }
 
 void AlcoholMeter::onConnectionStatedChanged(bool state)
 {
-    isConnected = state;
+    Q_UNUSED(state)
+    isConnected = std::any_of(transports.cbegin(), transports.cend(),
+                              [](const Transport *transport) { return transport->isConnected(); });
 }
 
 void AlcoholMeter::onDataReceived(QByteArray data)
 {
-    uint8_t parsedCommand;
-    uint8_t rw;
-    QByteArray parsedValue;
-    auto parsed = message.parseMessage(&data, parsedCommand, parsedValue, rw);
+    Protocol::Frame frame;
+    if (!Protocol::parseFrame(data, frame)) return;
+
+    // Tagged reads are answered to their sender only, untagged ones to everyone
+    Transport *transport = qobject_cast<Transport*>(sender());
+    const ReplyTarget requester{transport, transport ? transport->currentPeer() : 0};
+    const ReplyTarget source = frame.id ? requester : ReplyTarget();
 
-    if(!parsed)return;
-    float value = message.bytesToFloat(parsedValue);
-    if(rw == mRead)
+    if(frame.rw == mRead)
     {
-        switch (parsedCommand)
+        switch (frame.command)
         {
         case mCalcVal0:
         {
             adc0 = readADC(0);
-            sendData(mCalcVal0, adc0);
+            send<mCalcVal0>(adc0, frame.id, source);
             break;
         }
         case mCalcVal1:
         {
             adc1 = readADC(1);
-            sendData(mCalcVal1, adc1);
+            send<mCalcVal1>(adc1, frame.id, source);
             break;
         }
         case mCalcVal2:
         {
             adc2 = readADC(2);
-            sendData(mCalcVal2, adc2);
+            send<mCalcVal2>(adc2, frame.id, source);
             break;
         }
         case mCalcVal3:
         {
             adc3 = readADC(3);
-            sendData(mCalcVal3, adc3);
+            send<mCalcVal3>(adc3, frame.id, source);
             break;
         }
         case mR0:
         {
-            sendData(mR0, R0);
+            send<mR0>(R0, frame.id, source);
+            break;
+        }
+        case mQueryRange:
+        {
+            Protocol::TimeRange range;
+            if (Protocol::decode<mQueryRange, mRead>(frame, range))
+                queryRange(range, frame.id, requester);
+            break;
+        }
+        case mSyncRequest:
+        {
+            quint32 sequence = 0;
+            if (Protocol::decode<mSyncRequest, mRead>(frame, sequence))
+                syncHistory(sequence, frame.id, requester);
+            break;
+        }
+        case mMetrics:
+        {
+            send<mMetrics>(Metrics::instance().summary(), frame.id, source);
+            break;
+        }
+        case mFault:
+        {
+            send<mFault>(pipeline.fault(), frame.id, source);
+            break;
+        }
+        case mParam:
+        {
+            quint8 id = 0;
+            if (Protocol::decode<mParam, mRead>(frame, id))
+                send<mParam>(parameters->get(id), frame.id, source);
             break;
         }
         default:
             break;
         }
     }
-    else if(rw == mWrite)
+    else if(frame.rw == mWrite)
     {
-        switch (parsedCommand)
+        switch (frame.command)
         {
         case mStart:
         {
+            if (isStarting())
+                break;
             startMeasurement();
             break;
         }
@@ -309,10 +741,27 @@ void AlcoholMeter::onDataReceived(QByteArray data)
             stopMeasurement();
             break;
         }
+        case mArm:
+        {
+            if (isStarting())
+                break;
+            arm();
+            break;
+        }
+        case mParam:
+        {
+            // Answered like a read, with the value now in effect
+            ParameterValue request;
+            if (Protocol::decode<mParam, mWrite>(frame, request))
+                send<mParam>(parameters->set(request.id, request.value), frame.id, source);
+            break;
+        }
         case mCalibrate:
         {
+            if (isStarting())
+                break;
             R0 = calibrateSensor();
-            sendData(mR0, R0);            
+            send<mR0>(R0);
             break;
         }
         default:
@@ -323,14 +772,50 @@ void AlcoholMeter::onDataReceived(QByteArray data)
 
 void AlcoholMeter::setPinHigh(uint8_t pin) {
     digitalWrite(pin, HIGH);
-    qDebug() << "Set GPIO" << pin << "HIGH";
+    LOG_DEBUG(logGpio, "Set GPIO %.0f HIGH", pin);
 }
 
 void AlcoholMeter::setPinLow(uint8_t pin) {
     digitalWrite(pin, LOW);
-    qDebug() << "Set GPIO" << pin << "LOW";
+    LOG_DEBUG(logGpio, "Set GPIO %.0f LOW", pin);
 }
 
 bool AlcoholMeter::readPin(uint8_t pin) {
     return digitalRead(pin) == HIGH;
 }
+
+void AlcoholMeter::onGpioEdge(const GpioEdge &edge)
+{
+    if (edge.line != MQ3_STATUS_PIN)
+        return;
+
+    const quint64 latency = GpioEventSource::monotonicNow() - edge.timestamp;
+    Metrics::instance().gpioEdge.record(latency);
+    const bool present = edge.rising != MQ3_STATUS_ACTIVE_LOW;
+    if (present == alcoholPresent)
+        return;
+
+    alcoholPresent = present;
+    LOG_INFO(logGpio, "D0 edge, alcohol present %.0f, handled after %.1f us", present ? 1 : 0, latency / 1000.0);
+    emit alcoholDetected(present);
+
+    if (!present) {
+        if (armedIdle && measurementTimer->isActive())
+            releaseTimer->start();
+        return;
+    }
+
+    releaseTimer->stop();
+    // A comparator chattering around its threshold must not turn into
+    // back-to-back acquisitions, the periodic reading covers the hold-off
+    if (edgeReading.isValid() && edgeReading.elapsed() < EDGE_READING_HOLDOFF)
+        return;
+    edgeReading.start();
+
+    if (armed) {
+        wake();
+    } else if (measurementTimer->isActive()) {
+        // Measure right away instead of at the next tick
+        queueReading();
+    }
+}
@@ -2,35 +2,67 @@
 #define ALCOHOLMETER_H
 
 #include <QObject>
+#include <QDebug>
 #include <QTimer>
-#include "gattserver.h"
-#include "kalmanfilter.h"
-#include "message.h"
+#include <QDateTime>
+#include <QElapsedTimer>
+#include <QFuture>
+#include <QList>
+#include "transport.h"
+#include "measurementpipeline.h"
+#include "calibrationstore.h"
+#include "parameterregistry.h"
+#include "gpioeventsource.h"
+#include "measurementlog.h"
+#include "sessionstore.h"
+#include "startuptracker.h"
+#include "metrics.h"
+#include "protocol.h"
 
 class AlcoholMeter : public QObject {
     Q_OBJECT
 
 public:
     // Constants
-    static constexpr float VOLT_RESOLUTION = 32767.0f;    // 15-bit resolution for ADS1115
-    static constexpr float ADS1115_VOLTAGE_RANGE = 4.096f; // Using ±4.096V range
-    static constexpr float SENSOR_VCC = 5.0f;             // MQ3 sensor powered by 5V
-    static constexpr int READ_SAMPLES = 100;              // Number of samples for averaging
-    static constexpr float CLEAN_AIR_FACTOR = 70.0f;      // RS/R0 ratio in clean air
-    static constexpr int MEASUREMENT_INTERVAL = 1000;      // 1 second between measurements
-    static constexpr int WARMUP_TIME = 5;                 // 5 second warmup
+    static constexpr int RECORDS_PER_FRAME = 5;           // LogRecords per mRecords frame
+    static constexpr int FRAMES_PER_BURST = 8;            // Frames sent per stream timer tick
+    static constexpr int STREAM_INTERVAL = 20;            // ms between record bursts
+    static constexpr int SYNC_BATCH_RECORDS = 1024;       // Records compressed together for history sync
+    static constexpr int SYNC_CHUNK_SIZE = 160;           // Compressed bytes per mSyncBatch frame
+    static constexpr int ARMED_RELEASE_DELAY = 30000;     // Kiosk mode: back to armed idle after this long without alcohol
+    static constexpr int STATE_SAVE_INTERVAL = 30000;     // Calibration state snapshot while measuring
+    static constexpr int EDGE_READING_HOLDOFF = 1000;     // ms between readings triggered by D0 edges
+
+    // Streamed frames fit one BLE notification with a request id
+    static_assert(Protocol::FrameOverhead + 1 + RECORDS_PER_FRAME * static_cast<int>(sizeof(LogRecord)) <= Protocol::BleFrameLimit,
+                  "mRecords frames must fit one BLE notification");
+    static_assert(Protocol::FrameOverhead + 1 + static_cast<int>(sizeof(SyncChunkHeader)) + SYNC_CHUNK_SIZE <= Protocol::BleFrameLimit,
+                  "mSyncBatch frames must fit one BLE notification");
+    // chunkCount is one byte, even for a batch zlib can not shrink
+    static_assert((SYNC_BATCH_RECORDS * sizeof(LogRecord) * 101 / 100) / SYNC_CHUNK_SIZE < 255,
+                  "A sync batch must fit 255 chunks");
 
     static constexpr uint8_t MQ3_POWER_PIN     = 17;  // GPIO17 - Pin 11 - Control sensor power
     static constexpr uint8_t MQ3_STATUS_PIN    = 27;  // GPIO27 - Pin 13 - Get D0, Alcohol status
+    static constexpr bool MQ3_STATUS_ACTIVE_LOW = true;   // D0 is pulled low above the threshold
 
     explicit AlcoholMeter(QObject *parent = nullptr);
     ~AlcoholMeter();
 
     // Public interface methods
+    void addTransport(Transport *transport);
     void startMeasurement();
     void stopMeasurement();
+
+    // Armed idle: heater on and warm, no sampling and no telemetry until a
+    // D0 edge or mStart wakes the pipeline without another warm-up
+    void arm();
+    void setArmedIdle(bool enabled);
     float getCurrentR0() const;
 
+    // Start-up tasks of the meter and the caller's (BLE), readiness and first reading
+    StartupTracker *startup() const { return startupTracker; }
+
     void setPinHigh(uint8_t pin);
     void setPinLow(uint8_t pin);
     bool readPin(uint8_t pin);
@@ -39,23 +71,91 @@ public:
 
 signals:
     void measurementUpdated(float bac);
+    void alcoholDetected(bool present);
 
 private slots:
     void updateWarmup();
     void updateMeasurement();
     void onConnectionStatedChanged(bool state);
     void onDataReceived(QByteArray data);
+    void streamRecords();
+    void onGpioEdge(const GpioEdge &edge);
+    void applyParameters(const Parameters &parameters);
+    void saveState();
+    void onHardwareReady(AdcSource *source);
+    void onStateRestored(bool restored);
 
 private:
+    // Where a reply goes: one transport, and on transports with several
+    // clients the one that asked. No transport means every transport.
+    struct ReplyTarget {
+        Transport *transport = nullptr;
+        quint32 peer = 0;
+    };
+
     int readADC(int addr);
     float calibrateSensor();
     void toggleMeasurement();
-    void sendData(uint8_t command, float value);
+    void beginMeasuring();
+    void wake();
+    void queueReading();
+    int remainingWarmup() const;
     void sendString(QString value);
+    void publish(const QByteArray &frame, const ReplyTarget &target = {});
+    void queryRange(const Protocol::TimeRange &range, uint8_t id, const ReplyTarget &requester);
+    void syncHistory(quint32 sequence, uint8_t id, const ReplyTarget &requester);
+    Protocol::SyncState syncState() const;
+    void reportFault();
+    void finishStartup();
+    bool isStarting();
+
+    // Frame to every transport. Replies to a tagged read carry its id and
+    // only go to the client the read came from.
+    template<uint8_t Command>
+    void send(const Protocol::ValueOf<Command, mWrite> &value = {}, uint8_t id = 0, const ReplyTarget &target = {})
+    {
+        QByteArray frame;
+        {
+            StageTimer timer(Metrics::instance().stage(MetricsSummary::Encoding));
+            frame = Protocol::encode<Command, mWrite>(value, id);
+        }
+
+        if (frame.isEmpty()) {
+            qWarning() << "Failed to create message for command:" << Protocol::commandName(Command);
+            return;
+        }
+        publish(frame, target);
+    }
 
-    GattServer *gattServer{nullptr};
+    QList<Transport*> transports;
+    StartupTracker *startupTracker{nullptr};
+    QFuture<AdcSource*> hardwareInit;       // GPIO and ADC set-up, off the event loop
+    QFuture<bool> stateRestore;             // Calibration state read from disk
+    bool stateRestored = false;
+    bool started = false;                   // Hardware and state are in, commands are accepted
+    ParameterRegistry *parameters{nullptr};
+    Parameters params;                      // Snapshot in effect
+    MeasurementLog *measurementLog{nullptr};
+    SessionStore *sessionStore{nullptr};
+    CalibrationStore *calibrationStore{nullptr};
+    QTimer *stateTimer;
+    SessionStore::Cursor streamCursor;
+    quint32 streamedRecords = 0;
+    bool queryStreaming = false;
+    ReplyTarget streamTarget;               // Client of the running query
+    uint8_t streamId = 0;
+    QByteArray syncData;                    // Compressed sync batch still being sent
+    SyncChunkHeader syncHeader{};           // chunkIndex is the next chunk to send
+    bool syncComplete = false;              // The batch ends the log, mSyncDone follows it
+    ReplyTarget syncTarget;
+    uint8_t syncId = 0;
+    QTimer *streamTimer;                    // Paces query records and sync chunks
 
     bool isMeasuring;
+    bool armed = false;
+    bool armedIdle = false;                 // Return to armed idle instead of powering down
+    QElapsedTimer heaterTimer;              // Running while the heater is on
+    QTimer *releaseTimer;
     int warmupCount;
     bool isConnected = false;
     float R0 = 0.18f;
@@ -68,13 +168,17 @@ private:
     QTimer *warmupTimer;
     QTimer *adcTimer;          // New timer for ADC readings
 
-    KalmanFilter kalmanBac{0.1};
-    double measurementVariance = 0.5;
+    AdcSource *adcSource{nullptr};
+    GpioEventSource *gpioEvents{nullptr};
+    bool alcoholPresent = false;
+    bool readingQueued = false;
+    QElapsedTimer edgeReading;              // Since the last reading triggered by D0
+    quint8 lastFault = SensorFault::None;   // Kind last sent in an mFault
+    MeasurementPipeline pipeline;
     double timeDelta = 0.1;
     qreal p_dt{0.0};
     QDateTime p_end;                        // End time for calculations
     QDateTime p_start;
-    Message message;
 };
 
 #endif // ALCOHOLMETER_H
@@ -0,0 +1,45 @@
+QT = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# "qmake CONFIG+=sanitize" runs the checks under AddressSanitizer and UBSan
+sanitize {
+    CONFIG += debug sanitizer sanitize_address sanitize_undefined
+} else {
+    CONFIG -= debug
+    CONFIG += release
+}
+
+INCLUDEPATH += ../.. ../../common ../../AlcoholMeterClient
+
+SOURCES += \
+    ../../AlcoholMeterClient/decimatingbuffer.cpp \
+    ../../ads1115adcsource.cpp \
+    ../../decimator.cpp \
+    ../../fakeads1115.cpp \
+    ../../faultdetector.cpp \
+    ../../hampelfilter.cpp \
+    ../../kalmanfilter.cpp \
+    ../../measurementpipeline.cpp \
+    ../../metrics.cpp \
+    ../../replayadcsource.cpp \
+    ../../slidingmedian.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../AlcoholMeterClient/decimatingbuffer.h \
+    ../../common/metricssummary.h \
+    ../../common/sensorfault.h \
+    ../../adcsource.h \
+    ../../ads1115adcsource.h \
+    ../../decimator.h \
+    ../../fakeads1115.h \
+    ../../faultdetector.h \
+    ../../hampelfilter.h \
+    ../../i2cbus.h \
+    ../../kalmanfilter.h \
+    ../../measurementpipeline.h \
+    ../../metrics.h \
+    ../../replayadcsource.h \
+    ../../slidingmedian.h
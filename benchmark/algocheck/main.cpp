@@ -0,0 +1,384 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+#include <algorithm>
+#include <cmath>
+#include <deque>
+#include "ads1115adcsource.h"
+#include "decimatingbuffer.h"
+#include "decimator.h"
+#include "fakeads1115.h"
+#include "faultdetector.h"
+#include "hampelfilter.h"
+#include "measurementpipeline.h"
+#include "replayadcsource.h"
+#include "slidingmedian.h"
+
+// Behavioural checks of the signal chain: the sliding median against a
+// sorted reference, Hampel glitch rejection, unity DC gain and bounded
+// noise gain of every decimator, each FaultDetector kind (I2C errors
+// through FakeAds1115), the pipeline keeping faulty slots in its block and
+// the client's min/max level of detail. Exits with 1 if any check fails.
+
+namespace {
+
+struct Checks {
+    QTextStream &out;
+    int run = 0;
+    int failed = 0;
+
+    bool expect(bool ok, const QString &what)
+    {
+        run++;
+        if (!ok) {
+            failed++;
+            if (failed <= 20)
+                out << "FAIL: " << what << "\n";
+        }
+        return ok;
+    }
+};
+
+void checkSlidingMedian(Checks &checks, QRandomGenerator &random, int streams)
+{
+    const int windows[] = {1, 2, 3, 5, 15, 64, 255};
+    for (int window : windows) {
+        for (int stream = 0; stream < streams; ++stream) {
+            // Narrow ranges give many equal values, wide ones none
+            const int range = stream % 2 ? 8 : 65536;
+            SlidingMedian median(window);
+            std::deque<int> reference;
+            bool ok = true;
+            for (int i = 0; i < 4 * window + 100 && ok; ++i) {
+                if (i == 2 * window + 7) {
+                    median.clear();
+                    reference.clear();
+                }
+                const int value = random.bounded(range) - range / 2;
+                median.push(value);
+                reference.push_back(value);
+                if (int(reference.size()) > window)
+                    reference.pop_front();
+
+                QVector<int> sorted(reference.begin(), reference.end());
+                std::sort(sorted.begin(), sorted.end());
+                const int n = sorted.size();
+                const float expected = n % 2 ? sorted.at(n / 2) : (sorted.at(n / 2 - 1) + sorted.at(n / 2)) / 2.0f;
+                ok = median.size() == n && median.median() == expected
+                     && median.at(0) == sorted.first() && median.at(n - 1) == sorted.last();
+            }
+            checks.expect(ok, QString("sliding median of window %1, stream %2").arg(window).arg(stream));
+        }
+    }
+}
+
+void checkHampel(Checks &checks, QRandomGenerator &random)
+{
+    const int glitches[] = {0, 12, 20000, 32767};
+    for (int glitch : glitches) {
+        HampelFilter hampel;
+        for (int i = 0; i < HampelFilter::DEFAULT_WINDOW; ++i) {
+            hampel.filter(4800 + random.bounded(7) - 3);
+        }
+        const int filtered = hampel.filter(glitch);
+        checks.expect(std::abs(filtered - 4800) <= 3 && hampel.rejected() == 1,
+                      QString("Hampel rejects a glitch to %1, got %2").arg(glitch).arg(filtered));
+
+        const int clean = 4801;
+        checks.expect(hampel.filter(clean) == clean && hampel.rejected() == 1,
+                      "Hampel passes a clean sample after a glitch");
+    }
+
+    // Quantisation noise alone is never rejected
+    HampelFilter hampel;
+    for (int i = 0; i < 1000; ++i) {
+        const int sample = 4800 + random.bounded(2);
+        hampel.filter(sample);
+    }
+    checks.expect(hampel.rejected() == 0, "Hampel keeps samples within MIN_DEVIATION");
+
+    // A real step is followed once it fills half the window
+    hampel.reset();
+    for (int i = 0; i < HampelFilter::DEFAULT_WINDOW; ++i) {
+        hampel.filter(4800);
+    }
+    int last = 0;
+    for (int i = 0; i < HampelFilter::DEFAULT_WINDOW; ++i) {
+        last = hampel.filter(9000);
+    }
+    checks.expect(last == 9000, "Hampel follows a level change");
+}
+
+void checkDecimator(Checks &checks)
+{
+    const Decimator::Type types[] = {Decimator::Boxcar, Decimator::Fir, Decimator::Cic};
+    const double notches[] = {0.0, 50.0, 60.0};
+    const int counts[] = {1, 16, 64, 100, 128};
+    const double rates[] = {0.0, 250.0, 860.0};
+    const float level = 4816.0f;
+
+    for (Decimator::Type type : types) {
+        for (double notch : notches) {
+            Decimator::Config config;
+            config.type = type;
+            config.notch = notch;
+            Decimator decimator(config);
+            for (int count : counts) {
+                for (double rate : rates) {
+                    QVector<float> block(count, level);
+                    const float out = decimator.decimate(block.constData(), count, rate);
+                    checks.expect(std::abs(out - level) <= level * 1e-4f,
+                                  QString("decimator %1 (notch %2 Hz) DC gain over %3 samples at %4 Hz: %5")
+                                      .arg(int(type)).arg(notch).arg(count).arg(rate).arg(out));
+                }
+            }
+        }
+    }
+
+    // Mains hum on top of the level is rejected by the notched FIR
+    Decimator::Config config;
+    config.notch = 50.0;
+    Decimator decimator(config);
+    const double rate = 860.0;
+    QVector<float> block(128);
+    for (int i = 0; i < block.size(); ++i) {
+        block[i] = level + 200.0f * float(std::sin(2.0 * M_PI * 50.0 * i / rate));
+    }
+    const float out = decimator.decimate(block.constData(), block.size(), rate);
+    checks.expect(std::abs(out - level) < 5.0f, QString("FIR notch leaves %1 of 200 LSB hum").arg(out - level));
+}
+
+void checkDecimatorNoise(Checks &checks, QRandomGenerator &random)
+{
+    // Near mains or a submultiple of it the notch folds to DC; unit variance
+    // noise must never come out amplified
+    QVector<double> rates;
+    for (double rate = 24.0; rate <= 26.0; rate += 0.1) {
+        rates.append(rate);
+    }
+    for (double rate = 49.0; rate <= 51.0; rate += 0.1) {
+        rates.append(rate);
+    }
+    rates.append({16.7, 33.3, 100.0, 250.0, 860.0});
+
+    for (Decimator::Type type : {Decimator::Fir, Decimator::Cic}) {
+        Decimator::Config config;
+        config.type = type;
+        Decimator decimator(config);
+        QVector<float> block(100);
+        for (double rate : rates) {
+            double power = 0.0;
+            const int trials = 200;
+            for (int trial = 0; trial < trials; ++trial) {
+                for (float &sample : block) {
+                    sample = float((random.generateDouble() - 0.5) * std::sqrt(12.0));
+                }
+                const double out = decimator.decimate(block.constData(), block.size(), rate);
+                power += out * out;
+            }
+            const double deviation = std::sqrt(power / trials);
+            checks.expect(deviation < 1.5, QString("decimator %1 noise gain at %2 Hz: %3")
+                                               .arg(int(type)).arg(rate).arg(deviation));
+        }
+    }
+}
+
+void checkFaults(Checks &checks)
+{
+    struct Case {
+        SensorFault::Kind kind;
+        int raw;
+    };
+    const Case cases[] = {
+        {SensorFault::OpenCircuit, 0},
+        {SensorFault::OpenCircuit, FaultDetector::OPEN_CIRCUIT_LIMIT},
+        {SensorFault::RailSaturation, FaultDetector::RAIL_LIMIT},
+        {SensorFault::RailSaturation, 32767},
+        {SensorFault::I2cError, -1},
+    };
+    for (const Case &c : cases) {
+        FaultDetector faults;
+        faults.beginBlock();
+        checks.expect(faults.check(4800) == SensorFault::None && faults.check(c.raw) == c.kind,
+                      QString("raw %1 is %2").arg(c.raw).arg(sensorFaultName(c.kind)));
+
+        // Mostly faulty blocks are unusable and report the kind, mostly good ones are usable
+        for (int i = 0; i < 8; ++i) {
+            faults.check(c.raw);
+        }
+        const SensorFault &status = faults.endBlock();
+        checks.expect(status.kind == c.kind && status.faulty == 9 && status.samples == 10
+                      && status.value == qBound(-32768, c.raw, 32767),
+                      QString("block of %1 reports it").arg(sensorFaultName(c.kind)));
+
+        faults.beginBlock();
+        faults.check(c.raw);
+        for (int i = 0; i < 9; ++i) {
+            faults.check(4800 + i);
+        }
+        checks.expect(faults.endBlock().kind == SensorFault::None && faults.usable(),
+                      QString("block with one %1 sample is usable").arg(sensorFaultName(c.kind)));
+    }
+
+    // A converter repeating itself is stuck from the STUCK_RUN-th identical value on,
+    // also across blocks
+    FaultDetector faults;
+    faults.beginBlock();
+    bool ok = true;
+    for (int i = 1; i < FaultDetector::STUCK_RUN / 2; ++i) {
+        ok = ok && faults.check(5000) == SensorFault::None;
+    }
+    faults.endBlock();
+    faults.beginBlock();
+    for (int i = FaultDetector::STUCK_RUN / 2; i < FaultDetector::STUCK_RUN; ++i) {
+        ok = ok && faults.check(5000) == SensorFault::None;
+    }
+    ok = ok && faults.check(5000) == SensorFault::StuckAt && faults.check(5001) == SensorFault::None;
+    checks.expect(ok, "stuck converter is detected after STUCK_RUN identical values");
+
+    // A failing I2C transfer through the native driver is an I2C error
+    ReplayAdcSource source(QVector<int>{4800, 4801});
+    FakeAds1115 *bus = new FakeAds1115(&source);
+    Ads1115AdcSource driver(bus);
+    driver.setPaced(false);
+    faults.beginBlock();
+    const int good = driver.read(0);
+    bus->setFailing(true);
+    const int failed = driver.read(0);
+    checks.expect(good == 4800 && faults.check(good) == SensorFault::None
+                  && failed < 0 && faults.check(failed) == SensorFault::I2cError,
+                  QString("NACKed read through FakeAds1115 is an I2C error (read %1, then %2)").arg(good).arg(failed));
+}
+
+void checkPipeline(Checks &checks)
+{
+    // Every fourth conversion is an open circuit; the block keeps its
+    // length and the level comes through the FIR unchanged
+    QVector<int> trace(64, 4800);
+    for (int i = 0; i < trace.size(); i += 4) {
+        trace[i] = 0;
+    }
+    for (bool outliers : {true, false}) {
+        ReplayAdcSource source(trace);
+        MeasurementPipeline pipeline(&source);
+        pipeline.setSampleRate(860.0);
+        pipeline.setOutlierWindow(outliers ? HampelFilter::DEFAULT_WINDOW : 0);
+        const float value = pipeline.acquire(trace.size());
+        checks.expect(pipeline.usable() && pipeline.fault().faulty == 16 && std::abs(value - 4800.0f) < 0.5f,
+                      QString("pipeline fills faulty slots (outlier window %1): %2").arg(outliers).arg(value));
+    }
+
+    // A slow ramp read through a linear phase FIR comes out at the block
+    // centre; dropping the leading faulty samples would move it
+    for (int i = 0; i < trace.size(); ++i) {
+        trace[i] = i < 16 ? 0 : 4800 + i;
+    }
+    for (bool outliers : {true, false}) {
+        ReplayAdcSource source(trace);
+        MeasurementPipeline pipeline(&source);
+        pipeline.setSampleRate(860.0);
+        pipeline.setOutlierWindow(outliers ? HampelFilter::DEFAULT_WINDOW : 0);
+        const float value = pipeline.acquire(trace.size());
+        checks.expect(std::abs(value - (4800.0f + (trace.size() - 1) / 2.0f)) < 1.0f,
+                      QString("pipeline keeps the block spacing (outlier window %1): %2").arg(outliers).arg(value));
+    }
+
+    // Too many faults make the block unusable
+    ReplayAdcSource source(QVector<int>{0, 0, 0, 4800});
+    MeasurementPipeline pipeline(&source);
+    pipeline.setSampleRate(860.0);
+    pipeline.acquire(64);
+    checks.expect(!pipeline.usable() && pipeline.fault().kind == SensorFault::OpenCircuit,
+                  "pipeline reports a mostly open circuit block");
+}
+
+void checkDecimatingBuffer(Checks &checks, QRandomGenerator &random)
+{
+    const int capacity = 256;
+    const int factor = 8;
+    DecimatingBuffer buffer(capacity, 4, factor);
+    checks.expect(buffer.isEmpty(), "new buffer is empty");
+
+    QVector<float> values;
+    for (int i = 0; i < 3000; ++i) {
+        float value = float(random.bounded(1000));
+        if (i == 1234)
+            value = 1e6f;       // A single spike
+        buffer.append(i, value);
+        values.append(value);
+    }
+
+    for (int level = 0; level < buffer.levelCount(); ++level) {
+        // Each level covers its last capacity buckets of factor^level samples
+        int span = 1;
+        for (int l = 0; l < level; ++l) {
+            span *= factor;
+        }
+        const qint64 from = qMax<qint64>(0, values.size() - qint64(capacity - 1) * span);
+        const qint64 aligned = from / span * span;
+
+        bool ok = true;
+        qint64 previous = -1;
+        int points = 0;
+        buffer.forEach(level, aligned, [&](const DecimatingBuffer::Point &point) {
+            const int first = int(point.time);
+            const int last = qMin(first + span, int(values.size()));
+            const auto range = std::minmax_element(values.constBegin() + first, values.constBegin() + last);
+            ok = ok && point.time > previous && point.time % span == 0
+                 && point.min == *range.first && point.max == *range.second;
+            previous = point.time;
+            points++;
+        });
+        checks.expect(ok && points > 0, QString("level %1 holds min/max envelopes of %2 samples").arg(level).arg(span));
+
+        if (aligned <= 1234) {
+            float peak = 0.0f;
+            buffer.forEach(level, aligned, [&](const DecimatingBuffer::Point &point) {
+                peak = qMax(peak, point.max);
+            });
+            checks.expect(peak == 1e6f, QString("spike survives on level %1").arg(level));
+        }
+    }
+
+    checks.expect(buffer.levelFor(values.size() - 100, 200) == 0, "recent window uses raw samples");
+    checks.expect(buffer.levelFor(values.size() - 1000, 200) == 1, "wider window uses the first envelope level");
+    checks.expect(buffer.levelFor(0, 8) == buffer.levelCount() - 1, "whole history uses the coarsest level");
+
+    buffer.clear();
+    checks.expect(buffer.isEmpty(), "cleared buffer is empty");
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("algocheck");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Behavioural checks of the filters, fault detector and plot buffer");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"streams", "Random streams per sliding median window (default 20).", "count", "20"},
+        {"seed", "Random seed (default 1).", "seed", "1"},
+    });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    QRandomGenerator random(parser.value("seed").toUInt());
+    Checks checks{out};
+
+    checkSlidingMedian(checks, random, qMax(1, parser.value("streams").toInt()));
+    checkHampel(checks, random);
+    checkDecimator(checks);
+    checkDecimatorNoise(checks, random);
+    checkFaults(checks);
+    checkPipeline(checks);
+    checkDecimatingBuffer(checks, random);
+
+    out << checks.run << " checks, " << checks.failed << " failed\n";
+    out.flush();
+    return checks.failed ? 1 : 0;
+}
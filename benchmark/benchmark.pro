@@ -0,0 +1,9 @@
+# Host side benchmarks, none of them need wiringPi or Bluetooth:
+#   qmake benchmark/benchmark.pro && make && ./pipelinebench/pipelinebench
+TEMPLATE = subdirs
+
+SUBDIRS += \
+    algocheck \
+    gpiobench \
+    messagebench \
+    pipelinebench
@@ -0,0 +1,61 @@
+#include "benchutil.h"
+#include "metrics.h"
+#include <atomic>
+#include <cstddef>
+
+namespace {
+std::atomic<quint64> allocations{0};
+}
+
+#ifdef __GLIBC__
+// Interpose the C allocator so allocations inside Qt are counted too,
+// operator new alone misses QByteArray and friends.
+extern "C" {
+void *__libc_malloc(size_t size);
+void *__libc_calloc(size_t count, size_t size);
+void *__libc_realloc(void *pointer, size_t size);
+
+void *malloc(size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_malloc(size);
+}
+
+void *calloc(size_t count, size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_calloc(count, size);
+}
+
+void *realloc(void *pointer, size_t size)
+{
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    return __libc_realloc(pointer, size);
+}
+}
+#endif
+
+quint64 allocationCount()
+{
+    return allocations.load(std::memory_order_relaxed);
+}
+
+bool allocationsCounted()
+{
+#ifdef __GLIBC__
+    return true;
+#else
+    return false;
+#endif
+}
+
+void printLatency(QTextStream &out, const char *name, const LatencyHistogram &histogram)
+{
+    out << QString("  %1 %2 %3 %4 %5 %6\n")
+               .arg(name, -14)
+               .arg(histogram.percentile(50) / 1000.0, 10, 'f', 2)
+               .arg(histogram.percentile(90) / 1000.0, 10, 'f', 2)
+               .arg(histogram.percentile(99) / 1000.0, 10, 'f', 2)
+               .arg(histogram.max() / 1000.0, 10, 'f', 2)
+               .arg(histogram.count(), 10);
+}
@@ -0,0 +1,18 @@
+#ifndef BENCHUTIL_H
+#define BENCHUTIL_H
+
+#include <QtGlobal>
+#include <QTextStream>
+
+class LatencyHistogram;
+
+// Heap allocations (malloc, calloc, realloc and everything built on them,
+// operator new and Qt containers included) since the process started.
+// Returns false from allocationsCounted() on C libraries we can not hook.
+quint64 allocationCount();
+bool allocationsCounted();
+
+// One line of per-stage latencies in microseconds.
+void printLatency(QTextStream &out, const char *name, const LatencyHistogram &histogram);
+
+#endif // BENCHUTIL_H
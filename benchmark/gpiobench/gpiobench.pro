@@ -0,0 +1,22 @@
+QT = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Benchmarks are only meaningful with optimisations on
+CONFIG -= debug
+CONFIG += release
+
+INCLUDEPATH += .. ../.. ../../common
+
+SOURCES += \
+    ../../metrics.cpp \
+    ../../simulatedgpiochip.cpp \
+    ../benchutil.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../gpioeventsource.h \
+    ../../metrics.h \
+    ../../simulatedgpiochip.h \
+    ../benchutil.h
@@ -0,0 +1,76 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QTextStream>
+#include <QTimer>
+#include "benchutil.h"
+#include "metrics.h"
+#include "simulatedgpiochip.h"
+
+// Toggles a line of the simulated GPIO chip and measures how long an edge
+// takes from its timestamp to the handler in the event loop, the path the
+// daemon's D0 comparator events take. Fails if an edge is lost or arrives
+// with the wrong direction.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("gpiobench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("GPIO edge delivery benchmark");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"edges", "Edges to generate (default 20000).", "count", "20000"},
+        {"interval", "Milliseconds between edges, 0 toggles as fast as the event loop spins (default 0).", "ms", "0"},
+        {"burst", "Edges queued before the event loop runs (default 1).", "count", "1"},
+    });
+    parser.process(app);
+
+    const int edges = qMax(1, parser.value("edges").toInt());
+    const int interval = qMax(0, parser.value("interval").toInt());
+    const int burst = qMax(1, parser.value("burst").toInt());
+    constexpr unsigned LINE = 27;
+
+    SimulatedGpioChip chip;
+    chip.watch(LINE);
+
+    LatencyHistogram latency;
+    int generated = 0;
+    int received = 0;
+    int errors = 0;
+    bool expectRising = true;
+    QObject::connect(&chip, &GpioEventSource::edge, [&](const GpioEdge &edge) {
+        latency.record(GpioEventSource::monotonicNow() - edge.timestamp);
+        if (edge.line != LINE || edge.rising != expectRising)
+            errors++;
+        expectRising = !edge.rising;
+        if (++received == edges)
+            app.quit();
+    });
+
+    QTimer toggle;
+    toggle.setInterval(interval);
+    QObject::connect(&toggle, &QTimer::timeout, [&]() {
+        for (int i = 0; i < burst && generated < edges; ++i, ++generated) {
+            chip.setValue(LINE, !chip.value(LINE));
+        }
+        if (generated == edges)
+            toggle.stop();
+    });
+    toggle.start();
+
+    // Lost edges would otherwise hang the run
+    QTimer::singleShot(10000 + edges * (interval + 1), &app, &QCoreApplication::quit);
+    app.exec();
+
+    QTextStream out(stdout);
+    out << "Edges: " << received << " of " << edges << ", " << errors << " out of order\n\n";
+    out << QString("  %1 %2 %3 %4 %5 %6\n").arg("stage (us)", -14).arg("p50", 10).arg("p90", 10)
+               .arg("p99", 10).arg("max", 10).arg("count", 10);
+    printLatency(out, "gpio_edge", latency);
+
+    if (received != edges || errors) {
+        out << "\nFAIL: edges lost or out of order\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,213 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+#include <QTextStream>
+#include <QVector>
+#include <iterator>
+#include "message.h"
+
+// Encode/decode throughput of the frame format for every command and
+// payload size, and a fuzz loop throwing malformed frames at parseMessage
+// and frameSize. Build with "qmake CONFIG+=fuzz" to run the fuzz loop under
+// AddressSanitizer and UBSan.
+
+namespace {
+
+const uint8_t commands[] = {
+    mCalcVal0, mCalcVal1, mCalcVal2, mCalcVal3, mAdc0, mAdc1, mAdc2, mAdc3, mR0,
+    mStart, mStop, mCalibrate, mArm, mParam, mString, mQueryRange, mRecords,
+    mQueryDone, mSyncRequest, mSyncBatch, mSyncDone, mMetrics, mFault
+};
+
+const int payloadSizes[] = {0, 1, 4, 8, 16, 32, 64, 128, 192, 240, static_cast<int>(MaxPayload)};
+
+QByteArray randomBytes(QRandomGenerator &random, int size)
+{
+    QByteArray bytes(size, Qt::Uninitialized);
+    for (int i = 0; i < size; ++i) {
+        bytes[i] = static_cast<char>(random.bounded(256));
+    }
+    return bytes;
+}
+
+struct FuzzStats {
+    quint64 runs = 0;
+    quint64 accepted = 0;
+    quint64 failures = 0;
+};
+
+// Invariants of a parse, whatever the input was
+bool checkFrame(Message &message, QByteArray frame, const QByteArray *expectedPayload, FuzzStats &stats)
+{
+    uint8_t command = 0;
+    uint8_t rw = 0;
+    QByteArray value;
+    bool parsed = message.parseMessage(&frame, command, value, rw);
+    stats.runs++;
+
+    bool ok = true;
+    if (parsed) {
+        stats.accepted++;
+        const int len = static_cast<uint8_t>(frame.at(1));
+        const int idSize = (static_cast<uint8_t>(frame.at(2)) & Protocol::Tagged) ? 1 : 0;
+        ok = value.size() == len - 2 - idSize
+             && frame.size() >= value.size() + idSize + FrameOverhead
+             && value == frame.mid(4 + idSize, value.size())
+             && Message::frameSize(frame) == len + 4;
+    }
+    if (expectedPayload)
+        ok = ok && parsed && value == *expectedPayload;
+
+    int size = Message::frameSize(frame);
+    ok = ok && size <= frame.size();
+
+    if (!ok)
+        stats.failures++;
+    return ok;
+}
+
+void runBenchmarks(QTextStream &out, int iterations)
+{
+    Message message;
+    QRandomGenerator random(1);
+    volatile quint64 sink = 0;
+
+    out << QString("%1 %2 %3 %4 %5\n").arg("payload", 8).arg("encode ns", 12).arg("decode ns", 12)
+               .arg("encode MB/s", 12).arg("decode MB/s", 12);
+
+    for (int payloadSize : payloadSizes) {
+        const QByteArray payload = randomBytes(random, payloadSize);
+
+        // Every command must survive a round trip at every size
+        QVector<QByteArray> frames;
+        for (uint8_t command : commands) {
+            QByteArray frame = message.createMessage(command, mWrite, payload);
+            uint8_t parsedCommand = 0;
+            uint8_t rw = 0;
+            QByteArray value;
+            if (!message.parseMessage(&frame, parsedCommand, value, rw) || parsedCommand != command
+                || rw != mWrite || value != payload) {
+                out << "Round trip failed for command 0x" << QString::number(command, 16)
+                    << " with " << payloadSize << " byte payload\n";
+            }
+            frames.append(frame);
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < iterations; ++i) {
+            QByteArray frame = message.createMessage(commands[i % std::size(commands)], mWrite, payload);
+            sink = sink + frame.size();
+        }
+        const double encodeNs = double(timer.nsecsElapsed()) / iterations;
+
+        timer.restart();
+        for (int i = 0; i < iterations; ++i) {
+            uint8_t command = 0;
+            uint8_t rw = 0;
+            QByteArray value;
+            message.parseMessage(&frames[i % frames.size()], command, value, rw);
+            sink = sink + value.size();
+        }
+        const double decodeNs = double(timer.nsecsElapsed()) / iterations;
+
+        const double frameBytes = payloadSize + FrameOverhead;
+        out << QString("%1 %2 %3 %4 %5\n").arg(payloadSize, 8)
+                   .arg(encodeNs, 12, 'f', 1).arg(decodeNs, 12, 'f', 1)
+                   .arg(frameBytes / encodeNs * 1000.0, 12, 'f', 1)
+                   .arg(frameBytes / decodeNs * 1000.0, 12, 'f', 1);
+    }
+    Q_UNUSED(sink)
+}
+
+FuzzStats runFuzz(QTextStream &out, quint64 runs, quint32 seed)
+{
+    Message message;
+    QRandomGenerator random(seed);
+    FuzzStats stats;
+
+    QElapsedTimer timer;
+    timer.start();
+    while (stats.runs < runs) {
+        const uint8_t command = commands[random.bounded(int(std::size(commands)))];
+        const QByteArray payload = randomBytes(random, random.bounded(int(MaxPayload) + 1));
+        const QByteArray valid = message.createMessage(command, random.bounded(2) ? mRead : mWrite, payload);
+        checkFrame(message, valid, &payload, stats);
+
+        QByteArray frame = valid;
+        switch (random.bounded(6)) {
+        case 0:
+            // Pure noise, sometimes with a valid header
+            frame = randomBytes(random, random.bounded(300));
+            if (!frame.isEmpty() && random.bounded(2))
+                frame[0] = static_cast<char>(mHeader);
+            break;
+        case 1:
+            // Truncated anywhere, including inside the fixed fields
+            frame.truncate(random.bounded(frame.size()));
+            break;
+        case 2:
+            // len larger or smaller than the bytes that follow
+            frame[1] = static_cast<char>(random.bounded(256));
+            break;
+        case 3:
+            for (int flips = random.bounded(1, 4); flips > 0; --flips) {
+                int bit = random.bounded(frame.size() * 8);
+                frame[bit / 8] = static_cast<char>(frame.at(bit / 8) ^ (1 << (bit % 8)));
+            }
+            break;
+        case 4:
+            // Trailing garbage after a valid frame is ignored
+            frame.append(randomBytes(random, random.bounded(1, 64)));
+            checkFrame(message, frame, &payload, stats);
+            continue;
+        default:
+            // len pointing past the end of a short buffer
+            frame.truncate(qMin(frame.size(), 6));
+            frame[1] = static_cast<char>(0xff);
+            break;
+        }
+
+        if (!checkFrame(message, frame, nullptr, stats) && stats.failures <= 5) {
+            out << "Invariant broken for frame " << frame.toHex() << "\n";
+        }
+    }
+
+    const double seconds = timer.nsecsElapsed() / 1e9;
+    out << "Fuzz: " << stats.runs << " frames in " << QString::number(seconds, 'f', 2) << " s ("
+        << QString::number(stats.runs / seconds, 'f', 0) << " frames/s), "
+        << stats.accepted << " accepted, " << stats.failures << " invariant failures\n";
+    return stats;
+}
+
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("messagebench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Frame encode/decode benchmark and parser fuzzer");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"iterations", "Encodes and decodes per payload size (default 200000).", "count", "200000"},
+        {"fuzz", "Fuzzed frames to parse (default 1000000, 0 skips fuzzing).", "count", "1000000"},
+        {"seed", "Fuzzer seed (default 1).", "seed", "1"},
+        {"fuzz-only", "Skip the throughput benchmark."},
+    });
+    parser.process(app);
+
+    QTextStream out(stdout);
+    if (!parser.isSet("fuzz-only"))
+        runBenchmarks(out, qMax(1, parser.value("iterations").toInt()));
+
+    quint64 fuzzRuns = parser.value("fuzz").toULongLong();
+    if (fuzzRuns == 0)
+        return 0;
+
+    FuzzStats stats = runFuzz(out, fuzzRuns, parser.value("seed").toUInt());
+    out.flush();
+    return stats.failures ? 1 : 0;
+}
@@ -0,0 +1,21 @@
+QT = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# "qmake CONFIG+=fuzz" builds the fuzz loop with sanitizers
+fuzz {
+    CONFIG += debug sanitizer sanitize_address sanitize_undefined
+} else {
+    CONFIG -= debug
+    CONFIG += release
+}
+
+INCLUDEPATH += ../../common
+
+SOURCES += \
+    main.cpp
+
+HEADERS += \
+    ../../common/message.h \
+    ../../common/protocol.h
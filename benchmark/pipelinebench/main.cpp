@@ -0,0 +1,186 @@
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include "ads1115adcsource.h"
+#include "benchutil.h"
+#include "fakeads1115.h"
+#include "loopbacktransport.h"
+#include "measurementpipeline.h"
+#include "protocol.h"
+#include "metrics.h"
+#include "replayadcsource.h"
+#include <memory>
+
+// Drives the measurement pipeline of the daemon as fast as it goes, from a
+// recorded or synthetic ADC trace to frames on a loopback transport:
+// outlier rejection, decimation, Kalman filter, RS/R0 conversion, frame encoding and the
+// notification enqueue. No wiringPi, Bluetooth or sleeps involved.
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName("pipelinebench");
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Measurement pipeline benchmark");
+    parser.addHelpOption();
+    parser.addOptions({
+        {"trace", "ADC trace to replay, one raw value per line. A synthetic trace is used otherwise.", "file"},
+        {"measurements", "Measurements to run (default 20000).", "count", "20000"},
+        {"samples", "ADC samples decimated per measurement (default 100).", "count", "100"},
+        {"warmup", "Measurements run before recording starts (default 1000).", "count", "1000"},
+        {"budget", "Fail when the p99 of a whole measurement exceeds this many microseconds.", "us"},
+        {"driver", "Read the trace through the ADS1115 driver on a fake register map."},
+        {"decimator", "boxcar, fir or cic (default fir).", "type", "fir"},
+        {"mains", "Mains frequency to notch, 0 for none (default 50).", "hz", "50"},
+        {"glitches", "Fraction of synthetic samples read as 0, like an I2C error (default 0).", "fraction", "0"},
+        {"hampel-window", "Outlier rejection window in samples, 0 for none (default 15).", "count", "15"},
+        {"rate", "Sample rate the decimator is designed for (default 330, the daemon's).", "hz", "330"},
+    });
+    parser.process(app);
+
+    const int measurements = qMax(1, parser.value("measurements").toInt());
+    const int samples = qMax(1, parser.value("samples").toInt());
+    const int warmup = qMax(0, parser.value("warmup").toInt());
+    constexpr float R0 = 0.18f;
+    constexpr double DT = 1.0;          // The daemon measures once a second
+    constexpr int DRAIN_INTERVAL = 64;  // Measurements between event loop drains
+
+    ReplayAdcSource source;
+    if (parser.isSet("trace")) {
+        if (!source.load(parser.value("trace")))
+            return 2;
+    } else {
+        source.generate(samples * 300, 1, parser.value("glitches").toDouble());
+    }
+
+    // The trace behind the i2c driver, to count bus transactions per sample
+    FakeAds1115 *fakeBus = nullptr;
+    std::unique_ptr<Ads1115AdcSource> driver;
+    if (parser.isSet("driver")) {
+        fakeBus = new FakeAds1115(&source);
+        driver = std::make_unique<Ads1115AdcSource>(fakeBus);
+        driver->setPaced(false);
+        if (!driver->open())
+            return 2;
+    }
+
+    MeasurementPipeline pipeline(driver ? static_cast<AdcSource*>(driver.get()) : &source);
+    Decimator::Config decimator;
+    if (!Decimator::parseType(parser.value("decimator"), decimator.type)) {
+        QTextStream(stderr) << "Unknown decimator " << parser.value("decimator") << "\n";
+        return 2;
+    }
+    decimator.notch = parser.value("mains").toDouble();
+    pipeline.setDecimator(decimator);
+    pipeline.setOutlierWindow(parser.value("hampel-window").toInt());
+    // Without sleeps the measured rate would be meaningless
+    pipeline.setSampleRate(parser.value("rate").toDouble());
+
+    LoopbackTransport device;
+    LoopbackTransport client;
+    LoopbackTransport::connectPair(&device, &client);
+    device.start();
+    client.start();
+    quint64 framesReceived = 0;
+    QObject::connect(&client, &Transport::dataReceived, [&framesReceived](const QByteArray &) {
+        framesReceived++;
+    });
+
+    Metrics &metrics = Metrics::instance();
+    LatencyHistogram total;
+
+    auto runMeasurement = [&]() {
+        StageTimer timer(total);
+        float average = pipeline.acquire(samples);
+        Measurement measurement = pipeline.process(average, DT, R0);
+
+        QByteArray bacFrame;
+        QByteArray voltFrame;
+        {
+            StageTimer encodeTimer(metrics.stage(MetricsSummary::Encoding));
+            bacFrame = Protocol::encode<mCalcVal0, mWrite>(measurement.bac);
+            voltFrame = Protocol::encode<mAdc0, mWrite>(measurement.volt);
+        }
+        {
+            StageTimer sendTimer(metrics.stage(MetricsSummary::Send));
+            device.writeValue(bacFrame);
+            device.writeValue(voltFrame);
+        }
+        metrics.markReading();
+    };
+
+    for (int i = 0; i < warmup; ++i) {
+        runMeasurement();
+        if (i % DRAIN_INTERVAL == 0)
+            QCoreApplication::processEvents();
+    }
+    QCoreApplication::processEvents();
+    metrics.reset();
+    framesReceived = 0;
+
+    QElapsedTimer elapsed;
+    quint64 allocationsBefore = allocationCount();
+    const quint64 transfersBefore = fakeBus ? fakeBus->transfers() : 0;
+    quint64 drainAllocations = 0;
+    elapsed.start();
+    for (int i = 0; i < measurements; ++i) {
+        runMeasurement();
+        if ((i + 1) % DRAIN_INTERVAL == 0) {
+            // Delivery is the receiver's cost, keep it out of the allocation count
+            quint64 before = allocationCount();
+            QCoreApplication::processEvents();
+            drainAllocations += allocationCount() - before;
+        }
+    }
+    qint64 nanoseconds = elapsed.nsecsElapsed();
+    quint64 before = allocationCount();
+    QCoreApplication::processEvents();
+    drainAllocations += allocationCount() - before;
+    quint64 allocations = allocationCount() - allocationsBefore - drainAllocations;
+
+    const double seconds = nanoseconds / 1e9;
+    const quint64 rawSamples = metrics.samplesRead.load();
+
+    QTextStream out(stdout);
+    out << "Trace: " << (parser.isSet("trace") ? parser.value("trace") : QString("synthetic"))
+        << ", " << source.trace().size() << " values\n";
+    out << "Measurements: " << measurements << " x " << samples << " samples in "
+        << QString::number(seconds, 'f', 3) << " s\n";
+    out << "Throughput: " << QString::number(measurements / seconds, 'f', 0) << " measurements/s, "
+        << QString::number(rawSamples / seconds, 'f', 0) << " samples/s\n";
+    if (allocationsCounted()) {
+        out << "Allocations: " << QString::number(double(allocations) / measurements, 'f', 2) << " per measurement, "
+            << QString::number(double(allocations) / rawSamples, 'f', 4) << " per sample\n";
+    } else {
+        out << "Allocations: not counted on this C library\n";
+    }
+    if (fakeBus) {
+        out << "I2C transactions: " << QString::number(double(fakeBus->transfers() - transfersBefore) / rawSamples, 'f', 3)
+            << " per sample, " << fakeBus->configWrites() << " config writes\n";
+    }
+    out << "Faulty samples: " << metrics.samplesFaulty.load() << "\n";
+    out << "Rejected samples: " << metrics.samplesRejected.load() << " ("
+        << QString::number(100.0 * metrics.samplesRejected.load() / rawSamples, 'f', 3) << " %)\n";
+    out << "Frames delivered: " << framesReceived << "\n\n";
+
+    out << QString("  %1 %2 %3 %4 %5 %6\n").arg("stage (us)", -14).arg("p50", 10).arg("p90", 10)
+               .arg("p99", 10).arg("max", 10).arg("count", 10);
+    printLatency(out, "adc_read", metrics.adcRead);
+    for (int i = 0; i < MetricsSummary::StageCount; ++i) {
+        auto stage = static_cast<MetricsSummary::Stage>(i);
+        printLatency(out, Metrics::stageName(stage), metrics.stage(stage));
+    }
+    printLatency(out, "measurement", total);
+    out.flush();
+
+    if (parser.isSet("budget")) {
+        double budget = parser.value("budget").toDouble();
+        double p99 = total.percentile(99) / 1000.0;
+        if (p99 > budget) {
+            out << "\nFAIL: measurement p99 " << p99 << " us exceeds the budget of " << budget << " us\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,46 @@
+QT = core
+
+CONFIG += c++17 console
+CONFIG -= app_bundle
+
+# Benchmarks are only meaningful with optimisations on
+CONFIG -= debug
+CONFIG += release
+
+INCLUDEPATH += .. ../.. ../../common
+
+SOURCES += \
+    ../../common/loopbacktransport.cpp \
+    ../../ads1115adcsource.cpp \
+    ../../decimator.cpp \
+    ../../fakeads1115.cpp \
+    ../../faultdetector.cpp \
+    ../../hampelfilter.cpp \
+    ../../kalmanfilter.cpp \
+    ../../measurementpipeline.cpp \
+    ../../metrics.cpp \
+    ../../replayadcsource.cpp \
+    ../../slidingmedian.cpp \
+    ../benchutil.cpp \
+    main.cpp
+
+HEADERS += \
+    ../../common/loopbacktransport.h \
+    ../../common/metricssummary.h \
+    ../../common/parametervalue.h \
+    ../../common/sensorfault.h \
+    ../../common/transport.h \
+    ../../adcsource.h \
+    ../../ads1115adcsource.h \
+    ../../decimator.h \
+    ../../fakeads1115.h \
+    ../../faultdetector.h \
+    ../../hampelfilter.h \
+    ../../i2cbus.h \
+    ../../kalmanfilter.h \
+    ../../measurementpipeline.h \
+    ../../common/protocol.h \
+    ../../metrics.h \
+    ../../replayadcsource.h \
+    ../../slidingmedian.h \
+    ../benchutil.h
@@ -0,0 +1,121 @@
+#include "calibrationstore.h"
+#include <QDebug>
+#include <QFile>
+#include <QSaveFile>
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstring>
+
+static_assert(sizeof(FilterState) == 5 * sizeof(double), "FilterState is stored as is");
+
+CalibrationStore::CalibrationStore(const QString &fileName)
+    : m_fileName(fileName)
+{
+}
+
+bool CalibrationStore::load(qint64 now)
+{
+    QFile file(m_fileName);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
+
+    Snapshot snapshot;
+    const QByteArray data = file.readAll();
+    if (data.size() != sizeof(snapshot)) {
+        qWarning() << "Calibration state" << m_fileName << "has the wrong size, ignored";
+        return false;
+    }
+    memcpy(&snapshot, data.constData(), sizeof(snapshot));
+    if (memcmp(snapshot.magic, MAGIC, sizeof(MAGIC)) != 0 || snapshot.version != VERSION
+        || snapshot.checksum != qChecksum(QByteArrayView(data.constData(), offsetof(Snapshot, checksum)))) {
+        qWarning() << "Calibration state" << m_fileName << "is damaged, ignored";
+        return false;
+    }
+
+    m_baseline.clear();
+    for (int i = 0; i < qMin<int>(snapshot.baselineCount, BASELINE_HISTORY); ++i) {
+        if (std::isfinite(snapshot.baseline[i]))
+            m_baseline.append(snapshot.baseline[i]);
+    }
+
+    // Filter state is the most short-lived, a clock step back counts as stale
+    const qint64 age = now - snapshot.savedAt;
+    m_hasFilter = snapshot.hasFilter && age >= 0 && age <= MAX_FILTER_AGE
+                  && std::isfinite(snapshot.filter.abs) && std::isfinite(snapshot.filter.covAbsAbs);
+    if (m_hasFilter)
+        m_filter = snapshot.filter;
+
+    const qint64 calibrationAge = now - snapshot.calibratedAt;
+    if (calibrationAge < 0 || calibrationAge > MAX_CALIBRATION_AGE) {
+        qDebug() << "Calibration from" << snapshot.calibratedAt << "is too old, recalibrating";
+        return false;
+    }
+
+    const float r0 = snapshot.r0;
+    const float median = baselineMedian();
+    if (!std::isfinite(r0) || r0 < MIN_R0 || r0 > MAX_R0
+        || (median > 0 && std::fabs(r0 - median) > median * MAX_BASELINE_DEVIATION)) {
+        qWarning() << "Saved R0" << r0 << "is implausible, recalibrating";
+        return false;
+    }
+
+    m_r0 = r0;
+    m_calibratedAt = snapshot.calibratedAt;
+    return true;
+}
+
+bool CalibrationStore::save(qint64 now)
+{
+    Snapshot snapshot;
+    memset(&snapshot, 0, sizeof(snapshot));
+    memcpy(snapshot.magic, MAGIC, sizeof(MAGIC));
+    snapshot.version = VERSION;
+    snapshot.baselineCount = static_cast<quint16>(m_baseline.size());
+    snapshot.savedAt = now;
+    snapshot.calibratedAt = m_calibratedAt;
+    snapshot.r0 = m_r0;
+    std::copy(m_baseline.cbegin(), m_baseline.cend(), snapshot.baseline);
+    snapshot.hasFilter = m_hasFilter;
+    snapshot.filter = m_filter;
+    snapshot.checksum = qChecksum(QByteArrayView(reinterpret_cast<const char*>(&snapshot), offsetof(Snapshot, checksum)));
+
+    QSaveFile file(m_fileName);
+    if (!file.open(QIODevice::WriteOnly)
+        || file.write(reinterpret_cast<const char*>(&snapshot), sizeof(snapshot)) != sizeof(snapshot)
+        || !file.commit()) {
+        qWarning() << "Can not save calibration state to" << m_fileName << file.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool CalibrationStore::addCalibration(float r0, qint64 now)
+{
+    const float median = baselineMedian();
+    const bool plausible = median <= 0 || std::fabs(r0 - median) <= median * MAX_BASELINE_DEVIATION;
+
+    m_r0 = r0;
+    m_calibratedAt = now;
+    if (m_baseline.size() == BASELINE_HISTORY)
+        m_baseline.removeFirst();
+    m_baseline.append(r0);
+    return plausible;
+}
+
+float CalibrationStore::baselineMedian() const
+{
+    if (m_baseline.isEmpty())
+        return 0.0f;
+
+    QVector<float> sorted = m_baseline;
+    std::sort(sorted.begin(), sorted.end());
+    const int middle = sorted.size() / 2;
+    return sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2.0f;
+}
+
+void CalibrationStore::setFilterState(const FilterState &state)
+{
+    m_filter = state;
+    m_hasFilter = true;
+}
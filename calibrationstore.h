@@ -0,0 +1,71 @@
+#ifndef CALIBRATIONSTORE_H
+#define CALIBRATIONSTORE_H
+
+#include <QString>
+#include <QVector>
+#include "measurementpipeline.h"
+
+// Calibration state that survives a restart: R0 with the time it was
+// measured, the clean-air R0 of recent calibrations and the Kalman state.
+// The file is replaced atomically with QSaveFile, so a power cut leaves
+// either the old or the new snapshot. On load, R0 is only trusted while
+// it is young enough and plausible against the baseline. The Kalman state
+// is only trusted after a quick restart.
+class CalibrationStore
+{
+public:
+    static constexpr char MAGIC[4] = {'A', 'M', 'C', 'S'};
+    static constexpr quint16 VERSION = 1;
+    static constexpr int BASELINE_HISTORY = 16;                         // Calibrations remembered
+    static constexpr qint64 MAX_CALIBRATION_AGE = 7LL * 24 * 3600 * 1000; // ms, the MQ-3 drifts
+    static constexpr qint64 MAX_FILTER_AGE = 60 * 1000;                 // ms between save and load
+    static constexpr float MIN_R0 = 0.005f;
+    static constexpr float MAX_R0 = 10.0f;
+    static constexpr float MAX_BASELINE_DEVIATION = 0.5f;               // Of the baseline median
+
+    explicit CalibrationStore(const QString &fileName);
+
+    // Reads the snapshot, false if it is missing, damaged, stale or
+    // implausible. now is milliseconds since epoch.
+    bool load(qint64 now);
+    bool save(qint64 now);
+
+    // Records a fresh calibration, false if it is far off the baseline
+    // (it is recorded anyway, the sensor may really have changed)
+    bool addCalibration(float r0, qint64 now);
+
+    float r0() const { return m_r0; }
+    qint64 calibratedAt() const { return m_calibratedAt; }
+    float baselineMedian() const;
+
+    bool hasFilterState() const { return m_hasFilter; }
+    const FilterState &filterState() const { return m_filter; }
+    void setFilterState(const FilterState &state);
+
+    QString fileName() const { return m_fileName; }
+
+private:
+    // Naturally aligned without padding, the doubles are read in place
+    struct Snapshot {
+        char magic[4];
+        quint16 version;
+        quint16 baselineCount;
+        qint64 savedAt;                 // Milliseconds since epoch
+        qint64 calibratedAt;
+        FilterState filter;
+        float r0;
+        float baseline[BASELINE_HISTORY];   // Oldest first
+        quint8 hasFilter;
+        quint8 reserved;
+        quint16 checksum;               // qChecksum of everything before it
+    };
+
+    QString m_fileName;
+    float m_r0 = 0.0f;
+    qint64 m_calibratedAt = 0;
+    QVector<float> m_baseline;
+    bool m_hasFilter = false;
+    FilterState m_filter{};
+};
+
+#endif // CALIBRATIONSTORE_H
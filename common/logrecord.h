@@ -0,0 +1,49 @@
+#ifndef LOGRECORD_H
+#define LOGRECORD_H
+
+#include <QtGlobal>
+#include <QByteArrayView>
+#include <cstddef>
+
+#pragma pack(push, 1)
+// One measurement tick. Fixed size so segments can be addressed by index.
+struct LogRecord {
+    quint32 sequence;       // Monotonic across segments and restarts
+    qint64 timestamp;       // Milliseconds since epoch
+    float rawAdc;           // Averaged ADC counts before filtering
+    float filtered;         // Kalman filtered ADC counts
+    float bac;              // mg/L
+    float r0;
+    quint16 flags;
+    quint16 checksum;       // CRC-16 over the preceding bytes
+};
+
+struct LogSegmentHeader {
+    char magic[4];
+    quint16 version;
+    quint16 recordSize;
+    quint32 firstSequence;
+    quint32 epoch;          // Names the log, new whenever it starts from scratch
+};
+
+// Leads every mSyncBatch frame. A batch is a qCompress()ed run of
+// LogRecords split over chunkCount frames.
+struct SyncChunkHeader {
+    quint32 epoch;          // Log the records belong to
+    quint32 firstSequence;
+    quint16 recordCount;
+    quint8 chunkIndex;
+    quint8 chunkCount;
+};
+#pragma pack(pop)
+
+static_assert(sizeof(LogRecord) == 32, "LogRecord must stay 32 bytes");
+static_assert(sizeof(LogSegmentHeader) == 16, "LogSegmentHeader must stay 16 bytes");
+static_assert(sizeof(SyncChunkHeader) == 12, "SyncChunkHeader must stay 12 bytes");
+
+inline quint16 logRecordChecksum(const LogRecord &record)
+{
+    return qChecksum(QByteArrayView(reinterpret_cast<const char*>(&record), offsetof(LogRecord, checksum)));
+}
+
+#endif // LOGRECORD_H
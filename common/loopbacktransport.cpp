@@ -0,0 +1,77 @@
+#include "loopbacktransport.h"
+
+LoopbackTransport::LoopbackTransport(QObject *parent) : Transport(parent)
+{
+}
+
+LoopbackTransport::~LoopbackTransport()
+{
+    if (m_peer) {
+        LoopbackTransport *peer = m_peer;
+        peer->m_peer = nullptr;
+        peer->updateConnection();
+    }
+}
+
+void LoopbackTransport::connectPair(LoopbackTransport *a, LoopbackTransport *b)
+{
+    a->m_peer = b;
+    b->m_peer = a;
+    a->updateConnection();
+    b->updateConnection();
+}
+
+void LoopbackTransport::setQueued(bool queued)
+{
+    m_queued = queued;
+}
+
+void LoopbackTransport::start()
+{
+    m_started = true;
+    updateConnection();
+    if (m_peer)
+        m_peer->updateConnection();
+}
+
+void LoopbackTransport::stop()
+{
+    m_started = false;
+    updateConnection();
+    if (m_peer)
+        m_peer->updateConnection();
+}
+
+void LoopbackTransport::writeValue(const QByteArray &value)
+{
+    if (!m_connected)
+        return;
+
+    LoopbackTransport *peer = m_peer;
+    if (m_queued) {
+        QMetaObject::invokeMethod(peer, [peer, value]() { peer->deliver(value); }, Qt::QueuedConnection);
+    } else {
+        peer->deliver(value);
+    }
+}
+
+bool LoopbackTransport::isConnected() const
+{
+    return m_connected;
+}
+
+void LoopbackTransport::deliver(const QByteArray &value)
+{
+    if (m_started)
+        emit dataReceived(value);
+}
+
+void LoopbackTransport::updateConnection()
+{
+    bool connected = m_started && m_peer && m_peer->m_started;
+    if (connected == m_connected)
+        return;
+
+    m_connected = connected;
+    emit connectionState(m_connected);
+}
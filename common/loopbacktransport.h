@@ -0,0 +1,38 @@
+#ifndef LOOPBACKTRANSPORT_H
+#define LOOPBACKTRANSPORT_H
+
+#include <QPointer>
+#include "transport.h"
+
+// In-memory transport. Two instances are paired with connectPair(), after
+// which a frame written to one end is received by the other. Delivery is
+// queued through the event loop by default to behave like a radio link;
+// setQueued(false) delivers synchronously for latency measurements.
+class LoopbackTransport : public Transport
+{
+    Q_OBJECT
+
+public:
+    explicit LoopbackTransport(QObject *parent = nullptr);
+    ~LoopbackTransport();
+
+    static void connectPair(LoopbackTransport *a, LoopbackTransport *b);
+
+    void setQueued(bool queued);
+
+    void start() override;
+    void stop() override;
+    void writeValue(const QByteArray &value) override;
+    bool isConnected() const override;
+
+private:
+    void deliver(const QByteArray &value);
+    void updateConnection();
+
+    QPointer<LoopbackTransport> m_peer;
+    bool m_started = false;
+    bool m_connected = false;
+    bool m_queued = true;
+};
+
+#endif // LOOPBACKTRANSPORT_H
@@ -0,0 +1,92 @@
+#ifndef MESSAGE_H
+#define MESSAGE_H
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <QByteArray>
+#include "protocol.h"
+
+// Untyped frame helpers on top of protocol.h, for payloads assembled at
+// run time and for code that predates the typed Protocol::encode/decode.
+
+constexpr size_t MaxPayload = Protocol::MaxPayload;
+constexpr int FrameOverhead = Protocol::FrameOverhead;
+
+struct MessagePack {
+    uint8_t header;
+    uint8_t len;
+    uint8_t rw;
+    uint8_t command;
+    std::array<uint8_t, MaxPayload> data;
+    uint16_t checksum;
+};
+
+class Message {
+public:
+    Message() = default;
+
+    // Parses the frame at the start of dataUART, see Protocol::parseFrame
+    bool parse(const uint8_t *dataUART, int size, MessagePack *message)
+    {
+        Protocol::Frame frame;
+        if (!Protocol::parseFrame(reinterpret_cast<const char*>(dataUART), size, frame)) return false;
+
+        message->header = mHeader;
+        message->len = frame.size + 2;
+        message->rw = frame.rw;
+        message->command = frame.command;
+        memcpy(message->data.data(), frame.payload, frame.size);
+        const char *data = reinterpret_cast<const char*>(dataUART);
+        message->checksum = Protocol::checksum(data, static_cast<int>(frame.payload - data) + frame.size);
+        return true;
+    }
+
+    QByteArray createMessage(uint8_t command, uint8_t rw, const QByteArray& payload) {
+        return Protocol::encodeRaw(command, rw, payload.constData(), payload.size());
+    }
+
+    bool parseMessage(QByteArray *data, uint8_t &command, QByteArray &value,  uint8_t &rw)
+    {
+        Protocol::Frame frame;
+        if (!Protocol::parseFrame(*data, frame)) return false;
+
+        command = frame.command;
+        rw = frame.rw;
+        value.append(frame.payload, frame.size);
+        return true;
+    }
+
+    static int frameSize(const QByteArray &buffer)
+    {
+        return Protocol::frameSize(buffer);
+    }
+
+    template<typename T>
+    static T bytesTo(const QByteArray &bytes, int offset = 0) {
+        T value{};
+        if (offset < 0 || bytes.size() < offset + static_cast<int>(sizeof(T))) {
+            return value;
+        }
+        memcpy(&value, bytes.constData() + offset, sizeof(T));
+        return value;
+    }
+
+    template<typename T>
+    static QByteArray toBytes(T value) {
+        QByteArray bytes;
+        bytes.resize(sizeof(T));
+        memcpy(bytes.data(), &value, sizeof(T));
+        return bytes;
+    }
+
+    static float bytesToFloat(const QByteArray& bytes) {
+        return bytesTo<float>(bytes);
+    }
+
+    static QByteArray floatToBytes(float value) {
+        return toBytes(value);
+    }
+};
+
+#endif // MESSAGE_H
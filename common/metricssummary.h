@@ -0,0 +1,31 @@
+#ifndef METRICSSUMMARY_H
+#define METRICSSUMMARY_H
+
+#include <QtGlobal>
+
+#pragma pack(push, 1)
+// Payload of an mMetrics reply. Latencies are in microseconds.
+struct StageSummary {
+    quint32 count;
+    float p50;
+    float p99;
+    float max;
+};
+
+struct MetricsSummary {
+    enum Stage { Acquisition = 0, Filtering, Encoding, Send, StageCount };
+
+    quint32 uptime;             // Seconds since the daemon started
+    quint32 measurements;
+    quint32 framesSent;
+    quint32 framesDropped;
+    quint32 adcErrors;
+    quint32 staleness;          // Milliseconds since the last reading, 0xffffffff if none yet
+    StageSummary adcRead;
+    StageSummary stages[StageCount];
+};
+#pragma pack(pop)
+
+static_assert(sizeof(MetricsSummary) <= 253, "MetricsSummary must fit in one frame");
+
+#endif // METRICSSUMMARY_H
@@ -0,0 +1,28 @@
+#ifndef PARAMETERVALUE_H
+#define PARAMETERVALUE_H
+
+#include <QtGlobal>
+
+// Tunable parameters of the device, addressed by id over the protocol
+enum ParameterId : quint8 {
+    ParamAccelVariance = 1,     // Kalman acceleration noise variance
+    ParamMeasurementVariance,   // Kalman measurement variance
+    ParamReadSamples,           // ADC samples per reading
+    ParamSampleInterval,        // ms between samples of a reading
+    ParamMeasurementInterval,   // ms between readings
+    ParamWarmupTime             // Heater warm-up in seconds
+};
+
+#pragma pack(push, 1)
+// Payload of mParam writes. A client writes one to change a parameter,
+// the device answers reads and writes with the value in effect.
+struct ParameterValue {
+    enum Status : quint8 { Ok = 0, UnknownId, OutOfRange };
+
+    quint8 id;
+    quint8 status;              // Ok in requests, the outcome in replies
+    float value;
+};
+#pragma pack(pop)
+
+#endif // PARAMETERVALUE_H
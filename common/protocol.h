@@ -0,0 +1,303 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <QByteArray>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+#include "metricssummary.h"
+#include "parametervalue.h"
+#include "sensorfault.h"
+
+// Wire protocol shared by the device and the client. Every command and the
+// layout of its payload is described once in ALCOHOLMETER_PROTOCOL below;
+// command constants, payload types and the typed encode()/decode() are all
+// generated from it, so both ends always agree.
+//
+// Frame: header, len (payload + 2), rw, command, payload, 16-bit additive
+// checksum over everything before it, little endian.
+//
+// A request may carry an id: rw has the Tagged bit set and the id is the
+// first payload byte. The device echoes it in the reply, so a client can
+// keep several reads of one command in flight and tell replies apart from
+// unsolicited telemetry, which is never tagged. The mRecords and
+// mSyncBatch streams answering mQueryRange and mSyncRequest, and the
+// frame ending them, go only to the client that asked, with its id if any.
+
+namespace Protocol {
+
+constexpr uint8_t Header = 0xa0;
+constexpr uint8_t Write = 0x01;        // Commands to the device, data from it
+constexpr uint8_t Read = 0x02;         // Requests to the device
+constexpr uint8_t Tagged = 0x80;       // rw flag, a request id precedes the payload
+constexpr int MaxPayload = 253;        // len (payload + checksum) is one byte
+constexpr int FrameOverhead = 6;       // header, len, rw, command and checksum
+
+// Largest frame that fits one GATT notification at the smallest ATT MTU
+// clients negotiate (185 on iOS, 3 bytes of it are the ATT header). The
+// link does not fragment, so frames sent over BLE must stay within it;
+// MaxPayload only holds for stream transports.
+constexpr int BleFrameLimit = 182;
+
+// Payload kinds besides plain trivially copyable values
+struct Empty {};
+struct Bytes {};                       // Variable length, carried as QByteArray
+struct Text {};                        // Variable length local 8-bit text
+
+#pragma pack(push, 1)
+struct TimeRange {
+    qint64 from;                       // Milliseconds since epoch
+    qint64 to;
+};
+
+struct SyncState {
+    quint32 nextSequence;              // Device's next log sequence
+    quint32 epoch;                     // Device's log, see LogSegmentHeader
+};
+#pragma pack(pop)
+
+} // namespace Protocol
+
+// name, command byte, payload of Read frames, payload of Write frames
+#define ALCOHOLMETER_PROTOCOL(X)                                               \
+    X(CalcVal0,    0xa0, Empty,     float)                                     \
+    X(CalcVal1,    0xa1, Empty,     float)                                     \
+    X(CalcVal2,    0xa2, Empty,     float)                                     \
+    X(CalcVal3,    0xa3, Empty,     float)                                     \
+    X(Adc0,        0xb0, Empty,     float)                                     \
+    X(Adc1,        0xb1, Empty,     float)                                     \
+    X(Adc2,        0xb2, Empty,     float)                                     \
+    X(Adc3,        0xb3, Empty,     float)                                     \
+    X(R0,          0xb4, Empty,     float)                                     \
+    X(Start,       0xc0, Empty,     float)                                     \
+    X(Stop,        0xc1, Empty,     float)                                     \
+    X(Calibrate,   0xc2, Empty,     float)                                     \
+    X(Arm,         0xc3, Empty,     Empty)    /* heater on, wake on D0 or mStart */ \
+    X(Param,       0xc4, quint8,    ParameterValue) /* read by id, write to set */ \
+    X(String,      0xd0, Empty,     Text)                                      \
+    X(QueryRange,  0xe0, TimeRange, Empty)    /* answered with mRecords frames */ \
+    X(Records,     0xe1, Empty,     Bytes)    /* packed LogRecords */          \
+    X(QueryDone,   0xe2, Empty,     quint32)  /* number of records sent */     \
+    X(SyncRequest, 0xe3, quint32,   Empty)    /* next wanted sequence */       \
+    X(SyncBatch,   0xe4, Empty,     Bytes)    /* SyncChunkHeader + chunk */    \
+    X(SyncDone,    0xe5, Empty,     SyncState) /* device's log position */     \
+    X(Metrics,     0xe6, Empty,     MetricsSummary)                            \
+    X(Fault,       0xe7, Empty,     SensorFault)   /* on change and on read */
+
+constexpr uint8_t mHeader = Protocol::Header;
+constexpr uint8_t mWrite = Protocol::Write;
+constexpr uint8_t mRead = Protocol::Read;
+
+#define PROTOCOL_COMMAND(name, id, read, write) constexpr uint8_t m##name = id;
+ALCOHOLMETER_PROTOCOL(PROTOCOL_COMMAND)
+#undef PROTOCOL_COMMAND
+
+namespace Protocol {
+
+// How a payload kind is laid out. Fixed size kinds are copied as is.
+template<typename T>
+struct Codec {
+    static_assert(std::is_trivially_copyable_v<T>, "Fixed payloads must be trivially copyable");
+    static_assert(sizeof(T) <= MaxPayload, "Payload does not fit in a frame");
+
+    using Value = T;
+    static constexpr int Size = sizeof(T);
+
+    static int size(const T &) { return Size; }
+    static void write(char *out, const T &value) { memcpy(out, &value, Size); }
+    static bool read(const char *data, int size, T &value)
+    {
+        if (size != Size) return false;
+        memcpy(&value, data, Size);
+        return true;
+    }
+};
+
+template<>
+struct Codec<Empty> {
+    using Value = Empty;
+    static constexpr int Size = 0;
+
+    static int size(const Empty &) { return 0; }
+    static void write(char *, const Empty &) {}
+    static bool read(const char *, int, Empty &) { return true; }   // Extra bytes are ignored
+};
+
+template<>
+struct Codec<Bytes> {
+    using Value = QByteArray;
+    static constexpr int Size = -1;
+
+    static int size(const QByteArray &value) { return value.size(); }
+    static void write(char *out, const QByteArray &value) { memcpy(out, value.constData(), value.size()); }
+    static bool read(const char *data, int size, QByteArray &value)
+    {
+        value = QByteArray(data, size);
+        return true;
+    }
+};
+
+template<>
+struct Codec<Text> : Codec<Bytes> {};
+
+// Compile time description of a command, only commands of the schema exist
+template<uint8_t Command>
+struct Schema;
+
+#define PROTOCOL_SCHEMA(commandName, id, read, write)                           \
+    template<> struct Schema<id> {                                            \
+        static constexpr const char *Name = #commandName;                     \
+        using ReadPayload = read;                                             \
+        using WritePayload = write;                                           \
+    };
+ALCOHOLMETER_PROTOCOL(PROTOCOL_SCHEMA)
+#undef PROTOCOL_SCHEMA
+
+template<uint8_t Command, uint8_t Rw>
+using PayloadOf = std::conditional_t<Rw == Read,
+                                     typename Schema<Command>::ReadPayload,
+                                     typename Schema<Command>::WritePayload>;
+
+template<uint8_t Command, uint8_t Rw>
+using ValueOf = typename Codec<PayloadOf<Command, Rw>>::Value;
+
+// Payload size of a command, -1 when it is variable
+template<uint8_t Command, uint8_t Rw>
+constexpr int payloadSize() { return Codec<PayloadOf<Command, Rw>>::Size; }
+
+inline uint16_t checksum(const char *data, int size)
+{
+    uint16_t sum = 0;
+    for (int i = 0; i < size; ++i) {
+        sum += static_cast<uint8_t>(data[i]);
+    }
+    return sum;
+}
+
+// Writes header and checksum around a payload already at out + 4. With an
+// id the payload starts at out + 5 and size does not include the id.
+inline void seal(char *out, uint8_t command, uint8_t rw, int size, uint8_t id = 0)
+{
+    if (id) {
+        out[4] = static_cast<char>(id);
+        rw |= Tagged;
+        size++;
+    }
+    out[0] = static_cast<char>(Header);
+    out[1] = static_cast<char>(size + 2);
+    out[2] = static_cast<char>(rw);
+    out[3] = static_cast<char>(command);
+    uint16_t sum = checksum(out, 4 + size);
+    out[4 + size] = static_cast<char>(sum & 0xff);
+    out[5 + size] = static_cast<char>(sum >> 8);
+}
+
+// Frame of an untyped payload, empty if the payload is too large
+inline QByteArray encodeRaw(uint8_t command, uint8_t rw, const char *payload, int size, uint8_t id = 0)
+{
+    const int idSize = id ? 1 : 0;
+    if (size < 0 || size + idSize > MaxPayload)
+        return QByteArray();
+
+    QByteArray frame(FrameOverhead + idSize + size, Qt::Uninitialized);
+    if (size > 0)
+        memcpy(frame.data() + 4 + idSize, payload, size);
+    seal(frame.data(), command, rw, size, id);
+    return frame;
+}
+
+// Typed frame of a command, tagged with a request id unless id is 0
+template<uint8_t Command, uint8_t Rw>
+QByteArray encode(const ValueOf<Command, Rw> &value = {}, uint8_t id = 0)
+{
+    using PayloadCodec = Codec<PayloadOf<Command, Rw>>;
+    const int size = PayloadCodec::size(value);
+    const int idSize = id ? 1 : 0;
+    if (size + idSize > MaxPayload)
+        return QByteArray();
+
+    QByteArray frame(FrameOverhead + idSize + size, Qt::Uninitialized);
+    PayloadCodec::write(frame.data() + 4 + idSize, value);
+    seal(frame.data(), Command, Rw, size, id);
+    return frame;
+}
+
+// A validated frame; payload points into the buffer it was parsed from
+struct Frame {
+    uint8_t rw = 0;                    // Without the Tagged bit
+    uint8_t command = 0;
+    uint8_t id = 0;                    // Request id, 0 if the frame is not tagged
+    const char *payload = nullptr;
+    int size = 0;
+};
+
+// Parses the frame at the start of data. Frames shorter than their len
+// field, with a len below 2 or a bad checksum are rejected, so nothing
+// past size is ever read. Trailing bytes are ignored.
+inline bool parseFrame(const char *data, int size, Frame &frame)
+{
+    if (size < FrameOverhead || static_cast<uint8_t>(data[0]) != Header) return false;
+
+    const int len = static_cast<uint8_t>(data[1]);
+    if (len < 2 || 4 + len > size) return false;
+
+    const int payloadSize = len - 2;
+    const uint16_t sum = static_cast<uint8_t>(data[4 + payloadSize])
+                         | (static_cast<uint8_t>(data[5 + payloadSize]) << 8);
+    if (sum != checksum(data, 4 + payloadSize)) return false;
+
+    frame.rw = static_cast<uint8_t>(data[2]);
+    frame.command = static_cast<uint8_t>(data[3]);
+    frame.id = 0;
+    frame.payload = data + 4;
+    frame.size = payloadSize;
+    if (frame.rw & Tagged) {
+        if (payloadSize < 1) return false;
+        frame.rw &= ~Tagged;
+        frame.id = static_cast<uint8_t>(data[4]);
+        frame.payload++;
+        frame.size--;
+    }
+    return true;
+}
+
+inline bool parseFrame(const QByteArray &data, Frame &frame)
+{
+    return parseFrame(data.constData(), data.size(), frame);
+}
+
+// Typed payload of a frame, false if it is another command or malformed
+template<uint8_t Command, uint8_t Rw>
+bool decode(const Frame &frame, ValueOf<Command, Rw> &value)
+{
+    if (frame.command != Command || frame.rw != Rw)
+        return false;
+    return Codec<PayloadOf<Command, Rw>>::read(frame.payload, frame.size, value);
+}
+
+// Size of the first complete frame in a stream buffer, 0 if more bytes
+// are needed, or -1 if the buffer does not start with a header.
+inline int frameSize(const QByteArray &buffer)
+{
+    if (buffer.isEmpty()) return 0;
+    if (static_cast<uint8_t>(buffer.at(0)) != Header) return -1;
+    if (buffer.size() < 2) return 0;
+
+    int size = 4 + static_cast<uint8_t>(buffer.at(1));
+    return buffer.size() >= size ? size : 0;
+}
+
+inline const char *commandName(uint8_t command)
+{
+    switch (command) {
+#define PROTOCOL_NAME(name, id, read, write) case id: return #name;
+    ALCOHOLMETER_PROTOCOL(PROTOCOL_NAME)
+#undef PROTOCOL_NAME
+    default:
+        return "Unknown";
+    }
+}
+
+} // namespace Protocol
+
+#endif // PROTOCOL_H
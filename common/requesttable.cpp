@@ -0,0 +1,114 @@
+#include "requesttable.h"
+#include <limits>
+#include <utility>
+
+RequestTable::RequestTable(Transport *transport, QObject *parent)
+    : QObject(parent)
+    , m_transport(transport)
+{
+    m_clock.start();
+    m_expiryTimer = new QTimer(this);
+    m_expiryTimer->setSingleShot(true);
+    connect(m_expiryTimer, &QTimer::timeout, this, &RequestTable::expire);
+
+    connect(m_transport, &Transport::dataReceived, this, &RequestTable::onDataReceived);
+    connect(m_transport, &Transport::connectionState, this, &RequestTable::onConnectionState);
+}
+
+uint8_t RequestTable::request(uint8_t command, const QByteArray &payload, Handler handler, int timeout)
+{
+    const uint8_t id = nextId();
+    if (!id)
+        return 0;
+    const QByteArray frame = Protocol::encodeRaw(command, mRead, payload.constData(), payload.size(), id);
+    if (frame.isEmpty())
+        return 0;
+
+    track(id, command, std::move(handler), timeout);
+    m_transport->writeValue(frame);
+    return id;
+}
+
+void RequestTable::cancelAll()
+{
+    // Handlers may issue new requests, only fail the ones pending now
+    const QHash<uint8_t, Pending> pending = std::exchange(m_pending, {});
+    m_expiryTimer->stop();
+    for (const Pending &request : pending) {
+        request.handler(Disconnected, Protocol::Frame());
+    }
+}
+
+uint8_t RequestTable::nextId()
+{
+    // Ids wrap around 1..255, 0 marks untagged frames
+    for (int i = 0; i < std::numeric_limits<uint8_t>::max(); ++i) {
+        m_lastId = m_lastId == std::numeric_limits<uint8_t>::max() ? 1 : m_lastId + 1;
+        if (!m_pending.contains(m_lastId))
+            return m_lastId;
+    }
+    return 0;
+}
+
+void RequestTable::track(uint8_t id, uint8_t command, Handler handler, int timeout)
+{
+    m_pending.insert(id, Pending{command, m_clock.elapsed() + timeout, std::move(handler)});
+    scheduleExpiry();
+}
+
+void RequestTable::scheduleExpiry()
+{
+    if (m_pending.isEmpty()) {
+        m_expiryTimer->stop();
+        return;
+    }
+
+    qint64 earliest = std::numeric_limits<qint64>::max();
+    for (const Pending &request : std::as_const(m_pending)) {
+        earliest = qMin(earliest, request.deadline);
+    }
+    m_expiryTimer->start(static_cast<int>(qMax<qint64>(0, earliest - m_clock.elapsed())));
+}
+
+void RequestTable::onDataReceived(const QByteArray &data)
+{
+    Protocol::Frame frame;
+    if (!Protocol::parseFrame(data, frame) || !frame.id || frame.rw != mWrite)
+        return;
+
+    auto it = m_pending.find(frame.id);
+    if (it == m_pending.end() || it->command != frame.command) {
+        m_strayReplies++;
+        return;
+    }
+
+    Handler handler = std::move(it->handler);
+    m_pending.erase(it);
+    scheduleExpiry();
+    handler(Ok, frame);
+}
+
+void RequestTable::onConnectionState(bool connected)
+{
+    if (!connected)
+        cancelAll();
+}
+
+void RequestTable::expire()
+{
+    const qint64 now = m_clock.elapsed();
+    QList<Handler> expired;
+    for (auto it = m_pending.begin(); it != m_pending.end();) {
+        if (it->deadline <= now) {
+            expired.append(std::move(it->handler));
+            it = m_pending.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    scheduleExpiry();
+    for (const Handler &handler : std::as_const(expired)) {
+        handler(Timeout, Protocol::Frame());
+    }
+}
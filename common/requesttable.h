@@ -0,0 +1,86 @@
+#ifndef REQUESTTABLE_H
+#define REQUESTTABLE_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QTimer>
+#include <functional>
+#include "protocol.h"
+#include "transport.h"
+
+// Client side table of tagged reads in flight on one Transport. Every read
+// gets a free request id, replies complete it in whatever order they come
+// back, and a read fails when its timeout passes or the link drops. Untagged
+// frames are left to the telemetry path.
+class RequestTable : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Result { Ok, Timeout, Disconnected, Malformed };
+
+    using Handler = std::function<void(Result result, const Protocol::Frame &reply)>;
+
+    static constexpr int DEFAULT_TIMEOUT = 2000;    // ms
+
+    explicit RequestTable(Transport *transport, QObject *parent = nullptr);
+
+    // Sends a tagged read, returns its id or 0 if it could not be sent.
+    // The reply frame is only valid during the handler call.
+    uint8_t request(uint8_t command, const QByteArray &payload, Handler handler, int timeout = DEFAULT_TIMEOUT);
+
+    template<uint8_t Command>
+    uint8_t request(const Protocol::ValueOf<Command, mRead> &value,
+                    std::function<void(Result, const Protocol::ValueOf<Command, mWrite> &)> handler,
+                    int timeout = DEFAULT_TIMEOUT)
+    {
+        const uint8_t id = nextId();
+        if (!id)
+            return 0;
+        const QByteArray frame = Protocol::encode<Command, mRead>(value, id);
+        if (frame.isEmpty())
+            return 0;
+
+        track(id, Command, [handler](Result result, const Protocol::Frame &reply) {
+            Protocol::ValueOf<Command, mWrite> value{};
+            if (result == Ok && !Protocol::decode<Command, mWrite>(reply, value))
+                result = Malformed;
+            handler(result, value);
+        }, timeout);
+        m_transport->writeValue(frame);
+        return id;
+    }
+
+    int pending() const { return m_pending.size(); }
+
+    // Replies whose request already timed out or was never ours
+    quint64 strayReplies() const { return m_strayReplies; }
+
+    // Fails everything in flight with Disconnected
+    void cancelAll();
+
+private slots:
+    void onDataReceived(const QByteArray &data);
+    void onConnectionState(bool connected);
+    void expire();
+
+private:
+    struct Pending {
+        uint8_t command;
+        qint64 deadline;            // ms of m_clock
+        Handler handler;
+    };
+
+    uint8_t nextId();
+    void track(uint8_t id, uint8_t command, Handler handler, int timeout);
+    void scheduleExpiry();
+
+    Transport *m_transport;
+    QHash<uint8_t, Pending> m_pending;
+    QElapsedTimer m_clock;
+    QTimer *m_expiryTimer;
+    uint8_t m_lastId = 0;
+    quint64 m_strayReplies = 0;
+};
+
+#endif // REQUESTTABLE_H
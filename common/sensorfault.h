@@ -0,0 +1,39 @@
+#ifndef SENSORFAULT_H
+#define SENSORFAULT_H
+
+#include <QtGlobal>
+
+#pragma pack(push, 1)
+// Payload of an mFault frame: the sensor state of the last block of samples.
+// Sent when the kind changes and in reply to a read.
+struct SensorFault {
+    enum Kind : quint8 { None = 0, OpenCircuit, RailSaturation, StuckAt, I2cError, KindCount };
+
+    quint8 kind;                // Dominant fault, None while the block was usable
+    quint8 channel;
+    qint16 value;               // Last faulty raw value, negative for an I2C error code
+    quint16 faulty;             // Faulty samples in the block
+    quint16 samples;            // Samples in the block
+    quint32 total;              // Faulty samples since the daemon started
+};
+#pragma pack(pop)
+
+inline const char *sensorFaultName(quint8 kind)
+{
+    switch (kind) {
+    case SensorFault::None:
+        return "none";
+    case SensorFault::OpenCircuit:
+        return "open circuit";
+    case SensorFault::RailSaturation:
+        return "saturated";
+    case SensorFault::StuckAt:
+        return "stuck";
+    case SensorFault::I2cError:
+        return "I2C error";
+    default:
+        return "unknown";
+    }
+}
+
+#endif // SENSORFAULT_H
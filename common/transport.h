@@ -0,0 +1,40 @@
+#ifndef TRANSPORT_H
+#define TRANSPORT_H
+
+#include <QObject>
+#include <QByteArray>
+#include <QString>
+
+// A byte pipe carrying message.h frames between the device and a client.
+// Implemented by the BLE GATT server/client, the TCP endpoints and the
+// in-process loopback used to link device and client in one binary.
+class Transport : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit Transport(QObject *parent = nullptr) : QObject(parent) {}
+    virtual ~Transport() = default;
+
+    virtual void start() = 0;
+    virtual void stop() = 0;
+    virtual void writeValue(const QByteArray &value) = 0;
+    virtual bool isConnected() const = 0;
+
+    // Stable identity of the peer, for state kept per device. Empty when
+    // there is no single peer.
+    virtual QString peerId() const { return QString(); }
+
+    // Transports with several clients number them. While dataReceived is
+    // emitted, currentPeer() is the client the frame came from, and
+    // writeTo() sends to that client only. 0 addresses every client.
+    virtual quint32 currentPeer() const { return 0; }
+    virtual void writeTo(quint32 peer, const QByteArray &value) { Q_UNUSED(peer) writeValue(value); }
+
+signals:
+    void dataReceived(QByteArray);
+    void connectionState(bool);
+    void sendInfo(QString);
+};
+
+#endif // TRANSPORT_H
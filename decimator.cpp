@@ -0,0 +1,169 @@
+#include "decimator.h"
+#include <QtMath>
+#include <cmath>
+
+Decimator::Decimator(const Config &config)
+    : m_config(config)
+{
+}
+
+void Decimator::setConfig(const Config &config)
+{
+    m_config = config;
+    m_tapCount = 0;                 // Redesign on the next block
+}
+
+bool Decimator::parseType(const QString &name, Type &type)
+{
+    if (name == "boxcar")
+        type = Boxcar;
+    else if (name == "fir")
+        type = Fir;
+    else if (name == "cic")
+        type = Cic;
+    else
+        return false;
+    return true;
+}
+
+float Decimator::decimate(const float *samples, int count, double sampleRate)
+{
+    if (count <= 0)
+        return 0.0f;
+    if (sampleRate <= 0.0)
+        return boxcar(samples, count);
+
+    switch (m_config.type) {
+    case Fir:
+        return fir(samples, count, sampleRate);
+    case Cic:
+        return cic(samples, count, sampleRate);
+    default:
+        return boxcar(samples, count);
+    }
+}
+
+float Decimator::boxcar(const float *samples, int count) const
+{
+    float sum = 0.0f;
+    for (int i = 0; i < count; ++i) {
+        sum += samples[i];
+    }
+    return sum / count;
+}
+
+float Decimator::fir(const float *samples, int count, double sampleRate)
+{
+    // Taps only depend on the block length and rate, keep them while the
+    // rate stays within 2%
+    if (count != m_tapCount || std::abs(sampleRate - m_tapRate) > m_tapRate * 0.02)
+        designFir(count, sampleRate);
+
+    // Four independent partial sums, so the compiler can vectorise the dot
+    // product without being allowed to reorder float additions
+    const float *taps = m_taps.constData();
+    float lanes[4] = {0.0f, 0.0f, 0.0f, 0.0f};
+    int i = 0;
+    for (; i + 4 <= count; i += 4) {
+        lanes[0] += taps[i] * samples[i];
+        lanes[1] += taps[i + 1] * samples[i + 1];
+        lanes[2] += taps[i + 2] * samples[i + 2];
+        lanes[3] += taps[i + 3] * samples[i + 3];
+    }
+    for (; i < count; ++i) {
+        lanes[0] += taps[i] * samples[i];
+    }
+    return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+}
+
+void Decimator::designFir(int count, double sampleRate)
+{
+    m_tapCount = count;
+    m_tapRate = sampleRate;
+
+    // Slow calibration sampling aliases mains, notch where it folds to.
+    // A notch takes two taps of the block. Folded into the pass band, near
+    // a sample rate of mains or a submultiple of it, the notch would cancel
+    // the DC gain and normalising the taps would amplify noise, so the
+    // block is only low-pass filtered there.
+    const double cutoff = qBound(0.0, m_config.cutoff / sampleRate, 0.5);
+    double notch = std::fmod(m_config.notch, sampleRate) / sampleRate;
+    if (notch > 0.5)
+        notch = 1.0 - notch;
+    const bool useNotch = m_config.notch > 0.0 && notch >= NOTCH_MARGIN * cutoff && count > 3;
+    const int length = useNotch ? count - 2 : count;
+
+    QVector<double> lowPass(length);
+    const double middle = (length - 1) / 2.0;
+    for (int n = 0; n < length; ++n) {
+        const double t = n - middle;
+        const double sinc = t == 0.0 ? 2.0 * cutoff : std::sin(2.0 * M_PI * cutoff * t) / (M_PI * t);
+        const double phase = length > 1 ? 2.0 * M_PI * n / (length - 1) : 0.0;
+        const double window = 0.42 - 0.5 * std::cos(phase) + 0.08 * std::cos(2.0 * phase);
+        lowPass[n] = sinc * window;
+    }
+
+    // [1, -2 cos w0, 1] has its zeros exactly at the mains frequency
+    QVector<double> taps = lowPass;
+    if (useNotch) {
+        const double c = -2.0 * std::cos(2.0 * M_PI * notch);
+        taps.fill(0.0, count);
+        for (int n = 0; n < length; ++n) {
+            taps[n] += lowPass[n];
+            taps[n + 1] += c * lowPass[n];
+            taps[n + 2] += lowPass[n];
+        }
+    }
+
+    double sum = 0.0;
+    for (int n = 0; n < count; ++n) {
+        sum += taps[n];
+    }
+    m_taps.resize(count);
+    for (int n = 0; n < count; ++n) {
+        m_taps[n] = static_cast<float>(sum != 0.0 ? taps[n] / sum : 1.0 / count);
+    }
+}
+
+float Decimator::cic(const float *samples, int count, double sampleRate) const
+{
+    const int order = qBound(1, m_config.cicOrder, 6);
+
+    // The combs need order + 1 decimated outputs to settle
+    int rate = count / (order + 1);
+    if (m_config.notch > 0.0) {
+        const int mainsRate = qRound(sampleRate / m_config.notch);
+        if (mainsRate >= 1 && mainsRate <= rate)
+            rate = mainsRate;
+    }
+    if (rate < 1)
+        return boxcar(samples, count);
+
+    // Integers keep the integrator wrap-around exact
+    qint64 integrators[6] = {};
+    qint64 combs[6] = {};
+    qint64 output = 0;
+    const int start = count % rate;     // Align the last output with the block end
+    for (int i = start; i < count; ++i) {
+        integrators[0] += qRound64(samples[i]);
+        for (int k = 1; k < order; ++k) {
+            integrators[k] += integrators[k - 1];
+        }
+        if ((i - start + 1) % rate != 0)
+            continue;
+
+        qint64 value = integrators[order - 1];
+        for (int k = 0; k < order; ++k) {
+            const qint64 previous = combs[k];
+            combs[k] = value;
+            value -= previous;
+        }
+        output = value;
+    }
+
+    double gain = 1.0;
+    for (int k = 0; k < order; ++k) {
+        gain *= rate;
+    }
+    return static_cast<float>(output / gain);
+}
@@ -0,0 +1,57 @@
+#ifndef DECIMATOR_H
+#define DECIMATOR_H
+
+#include <QString>
+#include <QVector>
+
+// Reduces a block of ADC samples to one value for the Kalman filter.
+//
+// Fir: windowed-sinc (Blackman) low-pass over the whole block, optionally
+//      convolved with a two-zero notch at the mains frequency. With one
+//      output per block the polyphase decimator is a single dot product.
+// Cic: multiplier-free integrator/comb cascade. With a notch set, the
+//      decimation rate is sampleRate / mains, so the comb zeros land on
+//      the mains frequency and all its harmonics.
+// Boxcar: the plain average used before.
+//
+// All filters have unity DC gain, so calibration values are unchanged.
+class Decimator
+{
+public:
+    static constexpr double NOTCH_MARGIN = 2.0;     // Folded notch at least this many cutoffs above DC
+
+    enum Type { Boxcar, Fir, Cic };
+
+    struct Config {
+        Type type = Fir;
+        double cutoff = 5.0;        // Hz, Fir pass band edge
+        double notch = 50.0;        // Hz mains frequency to reject, 0 for none
+        int cicOrder = 3;
+    };
+
+    Decimator() = default;
+    explicit Decimator(const Config &config);
+
+    void setConfig(const Config &config);
+    const Config &config() const { return m_config; }
+
+    // Filter output at the end of the block, sampleRate in Hz. Without a
+    // known rate the block is averaged.
+    float decimate(const float *samples, int count, double sampleRate);
+
+    // "boxcar", "fir" or "cic", false for anything else
+    static bool parseType(const QString &name, Type &type);
+
+private:
+    float boxcar(const float *samples, int count) const;
+    float fir(const float *samples, int count, double sampleRate);
+    float cic(const float *samples, int count, double sampleRate) const;
+    void designFir(int count, double sampleRate);
+
+    Config m_config;
+    QVector<float> m_taps;          // Designed for m_tapCount samples at m_tapRate
+    int m_tapCount = 0;
+    double m_tapRate = 0.0;
+};
+
+#endif // DECIMATOR_H
@@ -0,0 +1,61 @@
+#include "fakeads1115.h"
+
+FakeAds1115::FakeAds1115(AdcSource *input, quint16 address)
+    : m_input(input)
+    , m_address(address)
+{
+    m_registers[1] = 0x8583;        // Power-on default config
+    m_registers[2] = 0x8000;
+    m_registers[3] = 0x7fff;
+}
+
+bool FakeAds1115::transfer(I2cMessage *messages, int count)
+{
+    m_transfers++;
+    if (m_failing)
+        return false;
+
+    for (int i = 0; i < count; ++i) {
+        I2cMessage &message = messages[i];
+        if (message.address != m_address)
+            return false;
+        if (message.read)
+            read(message);
+        else if (!write(message))
+            return false;
+    }
+    return true;
+}
+
+bool FakeAds1115::write(const I2cMessage &message)
+{
+    if (message.length < 1)
+        return false;
+
+    m_pointer = message.data[0] & 3;
+    if (message.length == 1)
+        return true;
+    if (message.length != 3 || m_pointer == 0)
+        return false;       // The conversion register is read only
+
+    m_registers[m_pointer] = static_cast<quint16>((message.data[1] << 8) | message.data[2]);
+    if (m_pointer == 1) {
+        m_configWrites++;
+        m_registers[1] &= 0x7fff;   // OS reads back 0 while converting
+    }
+    return true;
+}
+
+void FakeAds1115::read(I2cMessage &message)
+{
+    quint16 value = m_registers[m_pointer];
+    if (m_pointer == 0) {
+        // Single ended mux settings 4..7 select AIN0..AIN3
+        const int mux = (m_registers[1] >> 12) & 7;
+        const int raw = mux >= 4 && m_input ? m_input->read(mux - 4) : 0;
+        value = static_cast<quint16>(static_cast<qint16>(qBound(-32768, raw, 32767)));
+    }
+    for (int i = 0; i < message.length; ++i) {
+        message.data[i] = i == 0 ? static_cast<quint8>(value >> 8) : (i == 1 ? static_cast<quint8>(value & 0xff) : 0);
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef FAKEADS1115_H
+#define FAKEADS1115_H
+
+#include <array>
+#include "adcsource.h"
+#include "i2cbus.h"
+
+// Register map of an ADS1115 behind an I2cBus, for tests and benchmarks.
+// Conversions come from an AdcSource, read on the channel the mux selects.
+// Counts config writes so tests can check the driver's caching.
+class FakeAds1115 : public I2cBus
+{
+public:
+    explicit FakeAds1115(AdcSource *input, quint16 address = 0x48);
+
+    bool transfer(I2cMessage *messages, int count) override;
+
+    quint16 reg(int index) const { return m_registers[index & 3]; }
+    quint64 configWrites() const { return m_configWrites; }
+    void setFailing(bool failing) { m_failing = failing; }   // NACK every transfer
+
+private:
+    bool write(const I2cMessage &message);
+    void read(I2cMessage &message);
+
+    AdcSource *m_input;
+    quint16 m_address;
+    std::array<quint16, 4> m_registers{};
+    quint8 m_pointer = 0;
+    quint64 m_configWrites = 0;
+    bool m_failing = false;
+};
+
+#endif // FAKEADS1115_H
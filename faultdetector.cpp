@@ -0,0 +1,59 @@
+#include "faultdetector.h"
+
+void FaultDetector::beginBlock(int channel)
+{
+    for (auto &count : m_counts) {
+        count = 0;
+    }
+    m_samples = 0;
+    m_channel = channel;
+    // The run continues across blocks, a hung converter stays hung
+}
+
+SensorFault::Kind FaultDetector::check(int raw)
+{
+    m_samples++;
+
+    SensorFault::Kind kind = SensorFault::None;
+    if (raw < 0) {
+        kind = SensorFault::I2cError;
+    } else {
+        m_run = raw == m_lastRaw ? m_run + 1 : 1;
+        m_lastRaw = raw;
+        if (raw <= OPEN_CIRCUIT_LIMIT)
+            kind = SensorFault::OpenCircuit;
+        else if (raw >= RAIL_LIMIT)
+            kind = SensorFault::RailSaturation;
+        else if (m_run >= STUCK_RUN)
+            kind = SensorFault::StuckAt;
+    }
+
+    if (kind != SensorFault::None) {
+        m_counts[kind]++;
+        m_lastFaulty = static_cast<qint16>(qBound(-32768, raw, 32767));
+    }
+    return kind;
+}
+
+const SensorFault &FaultDetector::endBlock()
+{
+    // Good samples are not counted, so None only wins without faults
+    int faulty = 0;
+    int dominant = SensorFault::None;
+    for (int kind = SensorFault::None + 1; kind < SensorFault::KindCount; ++kind) {
+        faulty += m_counts[kind];
+        if (m_counts[kind] > m_counts[dominant])
+            dominant = kind;
+    }
+
+    const bool usable = m_samples > 0 && (m_samples - faulty) * 100 >= m_samples * MIN_GOOD_PERCENT;
+    if (usable)
+        dominant = SensorFault::None;
+    m_status.kind = static_cast<quint8>(dominant);
+    m_status.channel = static_cast<quint8>(m_channel);
+    m_status.value = m_lastFaulty;
+    m_status.faulty = static_cast<quint16>(faulty);
+    m_status.samples = static_cast<quint16>(m_samples);
+    m_status.total += faulty;
+    return m_status;
+}
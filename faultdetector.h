@@ -0,0 +1,41 @@
+#ifndef FAULTDETECTOR_H
+#define FAULTDETECTOR_H
+
+#include "sensorfault.h"
+
+// Classifies every raw conversion before it reaches the filters. An MQ-3
+// module with a broken heater or sensor lead reads ~0 V through its load
+// resistor, a short to 5 V saturates the ±4.096 V range, a hung converter
+// repeats its last result and a failed transfer returns a negative code.
+// Only counters and the current run length are kept, so a check is a few
+// compares per sample.
+class FaultDetector
+{
+public:
+    static constexpr int OPEN_CIRCUIT_LIMIT = 16;   // LSB (~2 mV), clean air reads ~4800
+    static constexpr int RAIL_LIMIT = 32760;        // LSB, at or above full scale
+    static constexpr int STUCK_RUN = 32;            // Identical conversions in a row
+    static constexpr int MIN_GOOD_PERCENT = 50;     // Good samples for a usable block
+
+    void beginBlock(int channel = 0);
+
+    // Fault of a raw conversion, SensorFault::None for a good sample
+    SensorFault::Kind check(int raw);
+
+    // Closes the block, its kind is None if it is usable
+    const SensorFault &endBlock();
+
+    const SensorFault &status() const { return m_status; }
+    bool usable() const { return m_status.kind == SensorFault::None; }
+
+private:
+    quint16 m_counts[SensorFault::KindCount] = {};
+    int m_samples = 0;
+    int m_lastRaw = -1;
+    int m_run = 0;
+    int m_channel = 0;
+    qint16 m_lastFaulty = 0;
+    SensorFault m_status = {};
+};
+
+#endif // FAULTDETECTOR_H
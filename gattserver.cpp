@@ -1,4 +1,6 @@
 #include "gattserver.h"
+#include "metrics.h"
+#include <QTimer>
 
 GattServer *GattServer::theInstance_= nullptr;
 
@@ -11,17 +13,38 @@ GattServer* GattServer::getInstance()
     return theInstance_;
 }
 
-GattServer::GattServer(QObject *parent) : QObject(parent)
+GattServer::GattServer(QObject *parent) : Transport(parent)
 {
     qRegisterMetaType<QLowEnergyController::ControllerState>();
     qRegisterMetaType<QLowEnergyController::Error>();
     qRegisterMetaType<QLowEnergyConnectionParameters>();
+
+    // Retried from the event loop, so a slow adapter never holds up the rest of start-up
+    advertiseTimer = new QTimer(this);
+    advertiseTimer->setSingleShot(true);
+    advertiseTimer->setInterval(ADVERTISE_RETRY_INTERVAL);
+    connect(advertiseTimer, &QTimer::timeout, this, &GattServer::tryAdvertising);
 }
 
 GattServer::~GattServer()
 {
 }
 
+void GattServer::start()
+{
+    startBleService();
+}
+
+void GattServer::stop()
+{
+    stopBleService();
+}
+
+bool GattServer::isConnected() const
+{
+    return m_ConnectionState;
+}
+
 void GattServer::onInfoReceived(QString info)
 {
     emit sendInfo(info);
@@ -115,31 +138,52 @@ void GattServer::startBleService()
     advertisingData.setLocalName("Alcohol Meter");
 
     // We have to check if advertising succeeded ot not. If there was an advertising error we will
-    // try to reinitialize our bluetooth service
-    while (leController->state() != QLowEnergyController::AdvertisingState) {
+    // try again until it does
+    beginAdvertising(false);
+}
+
+void GattServer::beginAdvertising(bool reset)
+{
+    resetOnRetry = reset;
+    advertiseTimer->stop();
+    leController->startAdvertising(params, advertisingData, advertisingData);
+    if (leController->state() == QLowEnergyController::AdvertisingState) {
+        tryAdvertising();
+    } else {
+        qDebug() << "Advertising did not start, retrying";
+        advertiseTimer->start();
+    }
+}
+
+void GattServer::tryAdvertising()
+{
+    if (!leController)
+        return;
+
+    if (leController->state() != QLowEnergyController::AdvertisingState) {
         qDebug() << "Attempting to start advertising...";
-        leController->startAdvertising(QLowEnergyAdvertisingParameters(), advertisingData, advertisingData);
-        QThread::msleep(1000);  // Add a delay to avoid tight loop
         //run this if not work "rfkill unblock bluetooth"
+        if (resetOnRetry)
+            resetBluetoothService();
+        leController->startAdvertising(params, advertisingData, advertisingData);
+        if (leController->state() != QLowEnergyController::AdvertisingState) {
+            advertiseTimer->start();
+            return;
+        }
     }
 
-    if(leController->state()== QLowEnergyController::AdvertisingState)
-    {
-        // writeTimer->start(1000);
-        auto statusText = QString("Listening for Ble connection %1").arg(advertisingData.localName());
-        emit sendInfo(statusText);
-        qDebug() << statusText;
-    }
-    else
-    {
-        auto statusText = QString("Ble connection can not start for %1").arg(advertisingData.localName());
-        emit sendInfo(statusText);
-        qDebug() << statusText;
-    }
+    auto statusText = QString("Listening for Ble connection %1").arg(advertisingData.localName());
+    emit sendInfo(statusText);
+    qDebug() << statusText;
+    emit advertising();
 }
 
 void GattServer::stopBleService()
 {
+    if (!leController)
+        return;
+
+    advertiseTimer->stop();
     if (leController->state() == QLowEnergyController::AdvertisingState || leController->state() == QLowEnergyController::ConnectedState)
     {
         QByteArray textData = "Ble service stopped!";
@@ -177,6 +221,15 @@ void GattServer::writeValue(const QByteArray &value)
     QLowEnergyCharacteristic cCharacteristic = service->characteristic(QBluetoothUuid(QUuid(RXUUID)));
     Q_ASSERT(cCharacteristic.isValid());
     service->writeCharacteristic(cCharacteristic, value);
+
+    // Without a central the notification only updates the local value
+    Metrics &metrics = Metrics::instance();
+    if (m_ConnectionState) {
+        metrics.framesSent.fetch_add(1, std::memory_order_relaxed);
+        metrics.bytesSent.fetch_add(value.size(), std::memory_order_relaxed);
+    } else {
+        metrics.framesDropped.fetch_add(1, std::memory_order_relaxed);
+    }
 }
 
 void GattServer::onCharacteristicChanged(const QLowEnergyCharacteristic &c, const QByteArray &value)
@@ -216,20 +269,8 @@ void GattServer::reConnect()
             QObject::connect(service.data(), &QLowEnergyService::characteristicChanged, this, &GattServer::onCharacteristicChanged);
             QObject::connect(service.data(), &QLowEnergyService::characteristicRead, this, &GattServer::onCharacteristicChanged);
 
-            leController->startAdvertising(params, advertisingData);
-
-            while (leController->state() != QLowEnergyController::AdvertisingState) {
-                resetBluetoothService();
-                leController->startAdvertising(params, advertisingData);
-            }
-
-            if (leController->state() == QLowEnergyController::AdvertisingState) {
-                auto statusText = QString("Listening for Ble connection %1").arg(advertisingData.localName());
-                emit sendInfo(statusText);
-            } else {
-                auto statusText = QString("Ble connection cannot start for %1").arg(advertisingData.localName());
-                emit sendInfo(statusText);
-            }
+            // Each retry restarts bluez first
+            beginAdvertising(true);
         }
     } catch(const std::exception& e) {
         qDebug() << "Error reconnect: " << e.what();
@@ -7,6 +7,7 @@
 #include <QtCore/qcoreapplication.h>
 #include <QtCore/qlist.h>
 #include <QtCore/qscopedpointer.h>
+#include "transport.h"
 
 #define SCANPARAMETERSUUID  "00001813-0000-1000-8000-00805f9b34fb"
 #define RXUUID              "0000AB01-0000-1000-8000-00805F9B34FB"  // For receiving commands
@@ -16,7 +17,7 @@ QT_USE_NAMESPACE
 
     typedef QSharedPointer<QLowEnergyService> ServicePtr;
 
-class GattServer : public QObject
+class GattServer : public Transport
 {
     Q_OBJECT
 
@@ -26,15 +27,26 @@ public:
 
     static GattServer* getInstance();
 
+    void start() override;
+    void stop() override;
+    void writeValue(const QByteArray &value) override;
+    bool isConnected() const override;
+
     void readValue();
-    void writeValue(const QByteArray &value);
     void startBleService();
     void stopBleService();
     void resetBluetoothService();
     void reConnect();
 
+    static constexpr int ADVERTISE_RETRY_INTERVAL = 1000;  // ms between advertising attempts
+
+signals:
+    // Advertising started, the service can be found by clients
+    void advertising();
+
 private:
     void addService(const QLowEnergyServiceData &serviceData);
+    void beginAdvertising(bool reset);
 
     QScopedPointer<QLowEnergyController> leController;
     QHash<QBluetoothUuid, ServicePtr> services;
@@ -47,17 +59,14 @@ private:
     QLowEnergyAdvertisingData advertisingData{};
 
     QTimer *writeTimer{};
+    QTimer *advertiseTimer{};
+    bool resetOnRetry = false;              // Restart bluez before each retry
     void writeValuePeriodically();
 
     static GattServer *theInstance_;
 
-signals:
-    void dataReceived(QByteArray);
-    void connectionState(bool);
-    void sendInfo(QString);
-
-
 private slots:
+    void tryAdvertising();
 
     //QLowEnergyService
     void onCharacteristicChanged(const QLowEnergyCharacteristic &c, const QByteArray &value);
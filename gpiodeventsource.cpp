@@ -0,0 +1,71 @@
+#include "gpiodeventsource.h"
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <gpiod.h>
+
+GpiodEventSource::GpiodEventSource(const QString &chip, QObject *parent)
+    : GpioEventSource(parent)
+    , m_chipName(chip)
+{
+}
+
+GpiodEventSource::~GpiodEventSource()
+{
+    for (const Watch &watch : std::as_const(m_lines)) {
+        delete watch.notifier;
+        gpiod_line_release(watch.line);
+    }
+    if (m_chip)
+        gpiod_chip_close(m_chip);
+}
+
+bool GpiodEventSource::watch(unsigned line)
+{
+    if (m_lines.contains(line))
+        return true;
+
+    if (!m_chip) {
+        m_chip = gpiod_chip_open_lookup(qPrintable(m_chipName));
+        if (!m_chip) {
+            qCritical() << "Can not open GPIO chip" << m_chipName << strerror(errno);
+            return false;
+        }
+    }
+
+    gpiod_line *handle = gpiod_chip_get_line(m_chip, line);
+    if (!handle || gpiod_line_request_both_edges_events(handle, "alcoholmeter") < 0) {
+        qCritical() << "Can not request edge events of GPIO" << line << strerror(errno);
+        return false;
+    }
+
+    auto *notifier = new QSocketNotifier(gpiod_line_event_get_fd(handle), QSocketNotifier::Read, this);
+    connect(notifier, &QSocketNotifier::activated, this, [this, line]() { readEvents(line); });
+    m_lines.insert(line, Watch{handle, notifier});
+    return true;
+}
+
+bool GpiodEventSource::value(unsigned line) const
+{
+    auto it = m_lines.constFind(line);
+    return it != m_lines.constEnd() && gpiod_line_get_value(it->line) == 1;
+}
+
+void GpiodEventSource::readEvents(unsigned line)
+{
+    const Watch watch = m_lines.value(line);
+    gpiod_line_event events[EVENT_BATCH];
+    const int count = gpiod_line_event_read_multiple(watch.line, events, EVENT_BATCH);
+    if (count < 0) {
+        qWarning() << "Reading GPIO" << line << "events failed:" << strerror(errno);
+        return;
+    }
+
+    for (int i = 0; i < count; ++i) {
+        GpioEdge edge;
+        edge.line = line;
+        edge.rising = events[i].event_type == GPIOD_LINE_EVENT_RISING_EDGE;
+        edge.timestamp = static_cast<quint64>(events[i].ts.tv_sec) * 1000000000ull + events[i].ts.tv_nsec;
+        emit this->edge(edge);
+    }
+}
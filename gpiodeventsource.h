@@ -0,0 +1,41 @@
+#ifndef GPIODEVENTSOURCE_H
+#define GPIODEVENTSOURCE_H
+
+#include <QHash>
+#include <QSocketNotifier>
+#include <QString>
+#include "gpioeventsource.h"
+
+struct gpiod_chip;
+struct gpiod_line;
+
+// GPIO edges from the Linux GPIO character device (libgpiod 1.x). Each
+// watched line has an event fd that a QSocketNotifier drains, so edges are
+// handled as soon as the event loop wakes up, with kernel timestamps.
+class GpiodEventSource : public GpioEventSource
+{
+    Q_OBJECT
+
+public:
+    static constexpr int EVENT_BATCH = 16;      // Events read per wakeup
+
+    explicit GpiodEventSource(const QString &chip = "gpiochip0", QObject *parent = nullptr);
+    ~GpiodEventSource();
+
+    bool watch(unsigned line) override;
+    bool value(unsigned line) const override;
+
+private:
+    struct Watch {
+        gpiod_line *line;
+        QSocketNotifier *notifier;
+    };
+
+    void readEvents(unsigned line);
+
+    QString m_chipName;
+    gpiod_chip *m_chip{nullptr};
+    QHash<unsigned, Watch> m_lines;
+};
+
+#endif // GPIODEVENTSOURCE_H
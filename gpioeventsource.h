@@ -0,0 +1,45 @@
+#ifndef GPIOEVENTSOURCE_H
+#define GPIOEVENTSOURCE_H
+
+#include <QObject>
+#include <time.h>
+
+// Edge of an input line, timestamped where it was detected
+struct GpioEdge {
+    unsigned line;
+    bool rising;
+    quint64 timestamp;          // ns of CLOCK_MONOTONIC
+};
+
+Q_DECLARE_METATYPE(GpioEdge)
+
+// Edge events of GPIO input lines, delivered into the Qt event loop. The
+// daemon watches the GPIO character device through libgpiod, benchmarks and
+// tests drive a SimulatedGpioChip.
+class GpioEventSource : public QObject
+{
+    Q_OBJECT
+
+public:
+    using QObject::QObject;
+    virtual ~GpioEventSource() = default;
+
+    // Requests rising and falling edges of an input line
+    virtual bool watch(unsigned line) = 0;
+
+    // Current level of a watched line
+    virtual bool value(unsigned line) const = 0;
+
+    // Same clock as GpioEdge::timestamp
+    static quint64 monotonicNow()
+    {
+        timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        return static_cast<quint64>(now.tv_sec) * 1000000000ull + now.tv_nsec;
+    }
+
+signals:
+    void edge(const GpioEdge &edge);
+};
+
+#endif // GPIOEVENTSOURCE_H
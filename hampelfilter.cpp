@@ -0,0 +1,34 @@
+#include "hampelfilter.h"
+#include <cmath>
+
+HampelFilter::HampelFilter(int window, double threshold)
+    : m_samples(window)
+    , m_deviations(window)
+    , m_threshold(threshold)
+{
+}
+
+int HampelFilter::filter(int sample)
+{
+    const float median = m_samples.median();
+    const int deviation = static_cast<int>(std::lround(std::fabs(sample - median)));
+    const bool judged = m_samples.size() >= MIN_FILL;
+    m_samples.push(sample);
+    m_deviations.push(deviation);
+    if (!judged)
+        return sample;
+
+    // 1.4826 scales the MAD to a standard deviation for Gaussian noise
+    const double limit = qMax<double>(MIN_DEVIATION, m_threshold * 1.4826 * m_deviations.median());
+    if (deviation <= limit)
+        return sample;
+
+    m_rejected++;
+    return static_cast<int>(std::lround(median));
+}
+
+void HampelFilter::reset()
+{
+    m_samples.clear();
+    m_deviations.clear();
+}
@@ -0,0 +1,42 @@
+#ifndef HAMPELFILTER_H
+#define HAMPELFILTER_H
+
+#include "slidingmedian.h"
+
+// Streaming Hampel outlier filter for raw ADC samples. A sample further
+// than threshold * 1.4826 * MAD from the median of the preceding window is
+// replaced by that median. The MAD is the sliding median of each sample's
+// distance to the median at its arrival, which needs no re-sort and is
+// O(log window) per sample like the median itself.
+//
+// Rejected samples still enter the window, so a real level change is
+// followed after window / 2 samples.
+class HampelFilter
+{
+public:
+    static constexpr int DEFAULT_WINDOW = 15;
+    static constexpr double DEFAULT_THRESHOLD = 3.0;
+    static constexpr int MIN_DEVIATION = 8;     // LSB, quantisation alone must not reject
+    static constexpr int MIN_FILL = 5;          // Samples needed before judging
+
+    explicit HampelFilter(int window = DEFAULT_WINDOW, double threshold = DEFAULT_THRESHOLD);
+
+    // The sample, or the window median if it is an outlier
+    int filter(int sample);
+
+    // Forgets the window, e.g. between blocks taken a second apart
+    void reset();
+
+    // Median of the window, 0 while it is empty
+    float median() const { return m_samples.median(); }
+    int window() const { return m_samples.window(); }
+    quint64 rejected() const { return m_rejected; }
+
+private:
+    SlidingMedian m_samples;
+    SlidingMedian m_deviations;
+    double m_threshold;
+    quint64 m_rejected = 0;
+};
+
+#endif // HAMPELFILTER_H
@@ -0,0 +1,54 @@
+#include "i2cbus.h"
+#include <QDebug>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <linux/i2c.h>
+#include <linux/i2c-dev.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+I2cDevBus::I2cDevBus(const QString &device)
+    : m_device(device)
+{
+}
+
+I2cDevBus::~I2cDevBus()
+{
+    if (m_fd >= 0)
+        close(m_fd);
+}
+
+bool I2cDevBus::open()
+{
+    if (m_fd >= 0)
+        return true;
+
+    m_fd = ::open(qPrintable(m_device), O_RDWR | O_CLOEXEC);
+    if (m_fd < 0) {
+        qCritical() << "Can not open" << m_device << strerror(errno);
+        return false;
+    }
+    return true;
+}
+
+bool I2cDevBus::transfer(I2cMessage *messages, int count)
+{
+    constexpr int MAX_MESSAGES = 4;
+    if (m_fd < 0 || count <= 0 || count > MAX_MESSAGES)
+        return false;
+
+    i2c_msg kernelMessages[MAX_MESSAGES];
+    for (int i = 0; i < count; ++i) {
+        kernelMessages[i].addr = messages[i].address;
+        kernelMessages[i].flags = messages[i].read ? I2C_M_RD : 0;
+        kernelMessages[i].len = messages[i].length;
+        kernelMessages[i].buf = messages[i].data;
+    }
+
+    i2c_rdwr_ioctl_data request;
+    request.msgs = kernelMessages;
+    request.nmsgs = count;
+    m_transfers++;
+    return ioctl(m_fd, I2C_RDWR, &request) == count;
+}
@@ -0,0 +1,46 @@
+#ifndef I2CBUS_H
+#define I2CBUS_H
+
+#include <QString>
+#include <QtGlobal>
+
+// One segment of a combined I2C transaction
+struct I2cMessage {
+    quint16 address;
+    bool read;
+    quint8 *data;
+    quint16 length;
+};
+
+// An I2C adapter that runs several messages as one transaction, with
+// repeated starts between them.
+class I2cBus
+{
+public:
+    virtual ~I2cBus() = default;
+
+    virtual bool transfer(I2cMessage *messages, int count) = 0;
+
+    // Transactions run so far, i.e. syscalls on a real adapter
+    quint64 transfers() const { return m_transfers; }
+
+protected:
+    quint64 m_transfers = 0;
+};
+
+// Linux i2c-dev adapter, every transfer() is a single I2C_RDWR ioctl
+class I2cDevBus : public I2cBus
+{
+public:
+    explicit I2cDevBus(const QString &device = "/dev/i2c-1");
+    ~I2cDevBus();
+
+    bool open();
+    bool transfer(I2cMessage *messages, int count) override;
+
+private:
+    QString m_device;
+    int m_fd = -1;
+};
+
+#endif // I2CBUS_H
@@ -32,6 +32,16 @@ void KalmanFilter::Reset(const double x_abs_value, const double x_vel_value)
     p_vel_vel_ = var_x_accel_;
 }
 
+void KalmanFilter::Restore(const double x_abs_value, const double x_vel_value,
+                           const double p_abs_abs, const double p_abs_vel, const double p_vel_vel)
+{
+    x_abs_ = x_abs_value;
+    x_vel_ = x_vel_value;
+    p_abs_abs_ = p_abs_abs;
+    p_abs_vel_ = p_abs_vel;
+    p_vel_vel_ = p_vel_vel;
+}
+
 void KalmanFilter::Update(const double z_abs, const double var_z_abs, const double dt)
 {
     // Some abbreviated constants to make the code line up nicely:
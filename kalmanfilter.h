@@ -43,6 +43,11 @@ public:
     void Reset(double x_abs_value);
     void Reset(double x_abs_value, double x_vel_value);
 
+    // Restores a state and covariance saved from the getters below, e.g.
+    // across a restart of the process.
+    void Restore(double x_abs_value, double x_vel_value,
+                 double p_abs_abs, double p_abs_vel, double p_vel_vel);
+
     /**
    * Sets the variance of the acceleration noise input to the system model in
    * x units per second squared.
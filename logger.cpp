@@ -0,0 +1,353 @@
+#include "logger.h"
+#include <QFile>
+#include <QThread>
+#include <cstdio>
+#include <cstring>
+
+LogCategory logMeter("meter", Logger::Info, 5);
+LogCategory logGpio("gpio", Logger::Info, 2);
+LogCategory logBle("ble", Logger::Info, 10);
+LogCategory logStorage("storage", Logger::Info, 10);
+LogCategory logQt("qt", Logger::Debug, 20);
+
+namespace {
+
+LogCategory *categories[] = {&logMeter, &logGpio, &logBle, &logStorage, &logQt};
+
+QtMessageHandler previousHandler = nullptr;
+
+void qtMessageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    Q_UNUSED(context)
+    Logger::Level level = Logger::Debug;
+    switch (type) {
+    case QtInfoMsg:
+        level = Logger::Info;
+        break;
+    case QtWarningMsg:
+        level = Logger::Warning;
+        break;
+    case QtCriticalMsg:
+    case QtFatalMsg:
+        level = Logger::Error;
+        break;
+    default:
+        break;
+    }
+    // Qt aborts right after a fatal message, the writer would never see it
+    if (type == QtFatalMsg) {
+        fprintf(stderr, "%s\n", qPrintable(message));
+        return;
+    }
+    Logger::instance().logText(level, logQt, message);
+}
+
+const char *levelName(int level)
+{
+    static const char *names[] = {"debug", "info", "warning", "error"};
+    return names[qBound(0, level, 3)];
+}
+
+enum BinaryRecord : quint8 {
+    BinaryString = 1,   // id, length, bytes
+    BinaryEntry = 2,    // timestamp, level, category id, format id, suppressed, argc, args
+    BinaryText = 3      // timestamp, level, category id, suppressed, length, bytes
+};
+
+}
+
+Logger &Logger::instance()
+{
+    static Logger logger;
+    return logger;
+}
+
+Logger::Logger()
+{
+    for (int i = 0; i < QUEUE_SIZE; ++i) {
+        m_slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+Logger::~Logger()
+{
+    stop();
+}
+
+void Logger::start(Format format, const QString &fileName)
+{
+    if (m_running)
+        return;
+
+    m_format = format;
+    m_file = new QFile;
+    bool opened = false;
+    if (fileName.isEmpty()) {
+        opened = m_file->open(stdout, QIODevice::WriteOnly | QIODevice::Unbuffered);
+    } else {
+        m_file->setFileName(fileName);
+        opened = m_file->open(QIODevice::WriteOnly | QIODevice::Append);
+    }
+
+    if (!opened) {
+        fprintf(stderr, "Can not open log output %s\n", qPrintable(fileName));
+        delete m_file;
+        m_file = nullptr;
+        return;
+    }
+
+    m_running = true;
+    m_thread = QThread::create([this]() { run(); });
+    m_thread->setObjectName("logger");
+    m_thread->start(QThread::LowPriority);
+    previousHandler = qInstallMessageHandler(qtMessageHandler);
+}
+
+void Logger::stop()
+{
+    if (!m_running)
+        return;
+
+    qInstallMessageHandler(previousHandler);
+    m_running = false;
+    m_thread->wait();
+    delete m_thread;
+    m_thread = nullptr;
+
+    m_file->close();
+    delete m_file;
+    m_file = nullptr;
+}
+
+void Logger::setLevel(Level level)
+{
+    for (LogCategory *category : categories) {
+        category->minLevel.store(level, std::memory_order_relaxed);
+    }
+}
+
+void Logger::logText(Level level, LogCategory &category, const QString &text)
+{
+    quint32 suppressed = 0;
+    if (!admit(level, category, suppressed))
+        return;
+
+    quint64 position;
+    Slot *slot = claim(position);
+    if (!slot)
+        return;
+
+    Entry &entry = slot->entry;
+    entry.timestamp = now();
+    entry.category = &category;
+    entry.format = nullptr;
+    entry.level = level;
+    entry.argCount = 0;
+    entry.suppressed = suppressed;
+    QByteArray utf8 = text.toUtf8();
+    int length = qMin(utf8.size(), TEXT_SIZE - 1);
+    memcpy(entry.text, utf8.constData(), length);
+    entry.text[length] = '\0';
+    publish(slot, position);
+}
+
+quint64 Logger::droppedEntries() const
+{
+    return m_dropped.load(std::memory_order_relaxed);
+}
+
+bool Logger::admit(Level level, LogCategory &category, quint32 &suppressed)
+{
+    if (level < category.minLevel.load(std::memory_order_relaxed))
+        return false;
+    if (category.ratePerSecond == 0 || level >= Error)
+        return true;
+
+    // Every message takes 1 / ratePerSecond seconds of the bucket, which
+    // holds at most one second worth
+    const qint64 cost = 1000000 / category.ratePerSecond;
+    const qint64 capacity = 1000000;
+    const qint64 timestamp = std::chrono::duration_cast<std::chrono::microseconds>(
+                                 std::chrono::steady_clock::now().time_since_epoch()).count();
+    qint64 fullAt = category.fullAt.load(std::memory_order_relaxed);
+    qint64 next;
+    do {
+        next = qMax(fullAt, timestamp) + cost;
+        if (next - timestamp > capacity) {
+            category.suppressed.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!category.fullAt.compare_exchange_weak(fullAt, next, std::memory_order_relaxed));
+
+    suppressed = category.suppressed.exchange(0, std::memory_order_relaxed);
+    return true;
+}
+
+Logger::Slot *Logger::claim(quint64 &position)
+{
+    // Bounded multi-producer queue: a slot is free for position p when its
+    // sequence equals p, and readable by the writer when it equals p + 1
+    position = m_enqueuePos.load(std::memory_order_relaxed);
+    for (;;) {
+        Slot &slot = m_slots[position & (QUEUE_SIZE - 1)];
+        quint64 sequence = slot.sequence.load(std::memory_order_acquire);
+        qint64 difference = static_cast<qint64>(sequence) - static_cast<qint64>(position);
+        if (difference == 0) {
+            if (m_enqueuePos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                return &slot;
+        } else if (difference < 0) {
+            // Full, never block the caller
+            m_dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        } else {
+            position = m_enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+void Logger::publish(Slot *slot, quint64 position)
+{
+    slot->sequence.store(position + 1, std::memory_order_release);
+}
+
+void Logger::run()
+{
+    while (m_running.load(std::memory_order_relaxed)) {
+        if (!drain())
+            QThread::msleep(WRITER_INTERVAL);
+    }
+    drain();
+}
+
+bool Logger::drain()
+{
+    bool drained = false;
+    for (;;) {
+        Slot &slot = m_slots[m_dequeuePos & (QUEUE_SIZE - 1)];
+        if (slot.sequence.load(std::memory_order_acquire) != m_dequeuePos + 1)
+            break;
+
+        if (m_format == Binary)
+            writeBinary(slot.entry);
+        else
+            writeJson(slot.entry);
+
+        slot.sequence.store(m_dequeuePos + QUEUE_SIZE, std::memory_order_release);
+        m_dequeuePos++;
+        drained = true;
+    }
+
+    if (!m_output.isEmpty()) {
+        m_file->write(m_output);
+        m_file->flush();
+        m_output.clear();
+    }
+    return drained;
+}
+
+void Logger::writeJson(const Entry &entry)
+{
+    char message[256];
+    if (entry.format)
+        formatMessage(entry, message, sizeof(message));
+    else
+        qstrncpy(message, entry.text, sizeof(message));
+
+    m_output.append("{\"ts\":").append(QByteArray::number(entry.timestamp));
+    m_output.append(",\"level\":\"").append(levelName(entry.level));
+    m_output.append("\",\"cat\":\"").append(entry.category->name);
+    m_output.append("\",\"msg\":\"");
+    for (const char *c = message; *c; ++c) {
+        switch (*c) {
+        case '"':
+            m_output.append("\\\"");
+            break;
+        case '\\':
+            m_output.append("\\\\");
+            break;
+        case '\n':
+            m_output.append("\\n");
+            break;
+        default:
+            if (static_cast<unsigned char>(*c) < 0x20)
+                m_output.append(' ');
+            else
+                m_output.append(*c);
+            break;
+        }
+    }
+    m_output.append('"');
+    if (entry.suppressed)
+        m_output.append(",\"suppressed\":").append(QByteArray::number(entry.suppressed));
+    m_output.append("}\n");
+}
+
+void Logger::writeBinary(const Entry &entry)
+{
+    quint16 category = internString(entry.category->name);
+    auto append = [this](const auto &value) {
+        m_output.append(reinterpret_cast<const char*>(&value), sizeof(value));
+    };
+
+    if (entry.format) {
+        quint16 format = internString(entry.format);
+        append(static_cast<quint8>(BinaryEntry));
+        append(entry.timestamp);
+        append(entry.level);
+        append(category);
+        append(format);
+        append(entry.suppressed);
+        append(entry.argCount);
+        for (int i = 0; i < entry.argCount; ++i) {
+            append(entry.args[i]);
+        }
+    } else {
+        quint16 length = qstrlen(entry.text);
+        append(static_cast<quint8>(BinaryText));
+        append(entry.timestamp);
+        append(entry.level);
+        append(category);
+        append(entry.suppressed);
+        append(length);
+        m_output.append(entry.text, length);
+    }
+}
+
+quint16 Logger::internString(const char *string)
+{
+    auto it = m_strings.constFind(string);
+    if (it != m_strings.constEnd())
+        return it.value();
+
+    // First use of a string, define it in the stream before referencing it
+    quint16 id = m_strings.size();
+    quint16 length = qstrlen(string);
+    m_strings.insert(string, id);
+    m_output.append(static_cast<char>(BinaryString));
+    m_output.append(reinterpret_cast<const char*>(&id), sizeof(id));
+    m_output.append(reinterpret_cast<const char*>(&length), sizeof(length));
+    m_output.append(string, length);
+    return id;
+}
+
+void Logger::formatMessage(const Entry &entry, char *buffer, int size)
+{
+    const auto &a = entry.args;
+    switch (entry.argCount) {
+    case 0:
+        snprintf(buffer, size, "%s", entry.format);
+        break;
+    case 1:
+        snprintf(buffer, size, entry.format, a[0]);
+        break;
+    case 2:
+        snprintf(buffer, size, entry.format, a[0], a[1]);
+        break;
+    case 3:
+        snprintf(buffer, size, entry.format, a[0], a[1], a[2]);
+        break;
+    default:
+        snprintf(buffer, size, entry.format, a[0], a[1], a[2], a[3]);
+        break;
+    }
+}
@@ -0,0 +1,147 @@
+#ifndef LOGGER_H
+#define LOGGER_H
+
+#include <QtGlobal>
+#include <QString>
+#include <QHash>
+#include <QByteArray>
+#include <atomic>
+#include <array>
+#include <chrono>
+#include <type_traits>
+
+class QThread;
+class QFile;
+
+// A log category with its own level threshold and rate limit. Categories
+// are defined once as globals and passed to the LOG_* macros.
+struct LogCategory {
+    const char *name;
+    std::atomic<int> minLevel;
+    int ratePerSecond;                  // 0 disables rate limiting
+
+    // Token bucket of ratePerSecond tokens kept as the steady clock time in
+    // microseconds at which it is full again, so admitting a message is one
+    // compare-and-swap and any thread may log to any category
+    std::atomic<qint64> fullAt{0};
+    std::atomic<quint32> suppressed{0};
+
+    LogCategory(const char *name, int minLevel, int ratePerSecond)
+        : name(name), minLevel(minLevel), ratePerSecond(ratePerSecond) {}
+};
+
+extern LogCategory logMeter;
+extern LogCategory logGpio;
+extern LogCategory logBle;
+extern LogCategory logStorage;
+extern LogCategory logQt;
+
+// Asynchronous structured logger. The hot path only copies a format string
+// pointer and up to MAX_ARGS numbers into a slot of a lock-free bounded
+// queue; formatting and output happen on a background writer thread, as
+// JSON lines or as a compact binary stream with interned format strings.
+// Arguments travel as doubles, so formats use %f, %g or %.0f conversions.
+class Logger
+{
+public:
+    enum Level { Debug = 0, Info, Warning, Error };
+    enum Format { JsonLines, Binary };
+
+    static constexpr int QUEUE_SIZE = 1024;         // Must be a power of two
+    static constexpr int MAX_ARGS = 4;
+    static constexpr int TEXT_SIZE = 120;           // Inline text for messages without a static format
+    static constexpr int WRITER_INTERVAL = 10;      // ms the writer sleeps when the queue is empty
+
+    struct Entry {
+        qint64 timestamp;                           // Microseconds since epoch
+        const LogCategory *category;
+        const char *format;                         // Static printf style format, nullptr for text
+        quint8 level;
+        quint8 argCount;
+        quint32 suppressed;                         // Messages of the category dropped by the rate limit before this one
+        std::array<double, MAX_ARGS> args;
+        char text[TEXT_SIZE];
+    };
+
+    static Logger &instance();
+
+    // Output goes to stdout unless a file is given. Installs a Qt message
+    // handler so qDebug() & co. take the same asynchronous path.
+    void start(Format format = JsonLines, const QString &fileName = QString());
+    void stop();
+    void setLevel(Level level);
+
+    template<typename... Args>
+    void log(Level level, LogCategory &category, const char *format, Args... args)
+    {
+        static_assert(sizeof...(Args) <= MAX_ARGS, "Too many log arguments");
+        static_assert((std::is_arithmetic_v<Args> && ...), "Log arguments must be numbers");
+        quint32 suppressed = 0;
+        if (!admit(level, category, suppressed))
+            return;
+
+        quint64 position;
+        Slot *slot = claim(position);
+        if (!slot)
+            return;
+
+        Entry &entry = slot->entry;
+        entry.timestamp = now();
+        entry.category = &category;
+        entry.format = format;
+        entry.level = level;
+        entry.argCount = sizeof...(Args);
+        entry.suppressed = suppressed;
+        int i = 0;
+        ((entry.args[i++] = static_cast<double>(args)), ...);
+        Q_UNUSED(i)
+        publish(slot, position);
+    }
+
+    void logText(Level level, LogCategory &category, const QString &text);
+
+    quint64 droppedEntries() const;
+
+private:
+    Logger();
+    ~Logger();
+
+    struct Slot {
+        std::atomic<quint64> sequence;
+        Entry entry;
+    };
+
+    static qint64 now() {
+        using namespace std::chrono;
+        return duration_cast<microseconds>(system_clock::now().time_since_epoch()).count();
+    }
+
+    bool admit(Level level, LogCategory &category, quint32 &suppressed);
+    Slot *claim(quint64 &position);
+    void publish(Slot *slot, quint64 position);
+    void run();
+    bool drain();
+    void writeJson(const Entry &entry);
+    void writeBinary(const Entry &entry);
+    quint16 internString(const char *string);
+    void formatMessage(const Entry &entry, char *buffer, int size);
+
+    std::array<Slot, QUEUE_SIZE> m_slots;
+    std::atomic<quint64> m_enqueuePos{0};
+    quint64 m_dequeuePos = 0;
+    std::atomic<quint64> m_dropped{0};
+    std::atomic<bool> m_running{false};
+
+    Format m_format = JsonLines;
+    QFile *m_file = nullptr;
+    QThread *m_thread = nullptr;
+    QHash<const char*, quint16> m_strings;          // Binary format string table, writer thread only
+    QByteArray m_output;
+};
+
+#define LOG_DEBUG(category, ...)   Logger::instance().log(Logger::Debug, category, __VA_ARGS__)
+#define LOG_INFO(category, ...)    Logger::instance().log(Logger::Info, category, __VA_ARGS__)
+#define LOG_WARNING(category, ...) Logger::instance().log(Logger::Warning, category, __VA_ARGS__)
+#define LOG_ERROR(category, ...)   Logger::instance().log(Logger::Error, category, __VA_ARGS__)
+
+#endif // LOGGER_H
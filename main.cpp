@@ -1,9 +1,76 @@
 #include <QCoreApplication>
+#include <QDebug>
 #include "alcoholmeter.h"
+#include "logger.h"
+#include "gattserver.h"
+#include "metricsserver.h"
+#include "telemetryserver.h"
 
-int main(int argc, char *argv[])
+static int runMeter(QCoreApplication &a)
 {
-    QCoreApplication a(argc, argv);
     AlcoholMeter meter;
+
+    qDebug() << "Starting gatt service";
+    // Advertising comes up alongside the hardware, the meter is ready once both are
+    GattServer *gattServer = GattServer::getInstance();
+    StartupTracker *startup = meter.startup();
+    startup->begin(StartupTracker::Ble);
+    QObject::connect(gattServer, &GattServer::advertising, startup, [startup]() {
+        startup->finish(StartupTracker::Ble);
+    });
+    meter.addTransport(gattServer);
+
+    // The local endpoint is optional, enable it with ALCOHOLMETER_TCP_PORT=<port>. It only
+    // listens on loopback, ALCOHOLMETER_TCP_BIND=<address>|any opens it to the network.
+    const QString portValue = qEnvironmentVariable("ALCOHOLMETER_TCP_PORT");
+    if (!portValue.isEmpty()) {
+        bool ok = false;
+        quint16 port = portValue.toUShort(&ok);
+        const QString bindValue = qEnvironmentVariable("ALCOHOLMETER_TCP_BIND");
+        QHostAddress address(QHostAddress::LocalHost);
+        if (bindValue == "any")
+            address = QHostAddress::Any;
+        else if (!bindValue.isEmpty() && !address.setAddress(bindValue))
+            ok = false;
+
+        if (ok)
+            meter.addTransport(new TelemetryServer(port ? port : TelemetryServer::DEFAULT_PORT, address));
+        else
+            qWarning() << "Invalid ALCOHOLMETER_TCP_PORT or ALCOHOLMETER_TCP_BIND:" << portValue << bindValue;
+    }
+
+    // Plain text metrics for scraping, enable with ALCOHOLMETER_METRICS_PORT=<port>
+    MetricsServer metricsServer;
+    const QString metricsPort = qEnvironmentVariable("ALCOHOLMETER_METRICS_PORT");
+    if (!metricsPort.isEmpty()) {
+        bool ok = false;
+        quint16 port = metricsPort.toUShort(&ok);
+        if (ok)
+            metricsServer.listen(port ? port : MetricsServer::DEFAULT_PORT);
+        else
+            qWarning() << "Invalid ALCOHOLMETER_METRICS_PORT:" << metricsPort;
+    }
+
     return a.exec();
 }
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication a(argc, argv);
+
+    // ALCOHOLMETER_LOG_FORMAT=binary and ALCOHOLMETER_LOG_FILE=<path> select the log sink
+    Logger &logger = Logger::instance();
+    const QString level = qEnvironmentVariable("ALCOHOLMETER_LOG_LEVEL");
+    if (level == "debug")
+        logger.setLevel(Logger::Debug);
+    else if (level == "warning")
+        logger.setLevel(Logger::Warning);
+    else if (level == "error")
+        logger.setLevel(Logger::Error);
+    logger.start(qEnvironmentVariable("ALCOHOLMETER_LOG_FORMAT") == "binary" ? Logger::Binary : Logger::JsonLines,
+                 qEnvironmentVariable("ALCOHOLMETER_LOG_FILE"));
+
+    int result = runMeter(a);
+    logger.stop();
+    return result;
+}
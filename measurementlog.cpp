@@ -0,0 +1,283 @@
+#include "measurementlog.h"
+#include <QDir>
+#include <QFileInfo>
+#include <QRandomGenerator>
+#include <QDebug>
+#include <cstring>
+#include <unistd.h>
+
+MeasurementLog::MeasurementLog(const QString &directory, QObject *parent)
+    : QObject(parent)
+    , m_directory(directory)
+{
+    m_buffer.reserve(BLOCK_SIZE);
+
+    flushTimer = new QTimer(this);
+    flushTimer->setInterval(FLUSH_INTERVAL);
+    connect(flushTimer, &QTimer::timeout, this, &MeasurementLog::flush);
+
+    syncTimer = new QTimer(this);
+    syncTimer->setInterval(SYNC_INTERVAL);
+    connect(syncTimer, &QTimer::timeout, this, &MeasurementLog::sync);
+}
+
+MeasurementLog::~MeasurementLog()
+{
+    close();
+}
+
+bool MeasurementLog::open()
+{
+    QDir dir(m_directory);
+    if (!dir.exists() && !dir.mkpath(".")) {
+        qWarning() << "Can not create measurement log directory" << m_directory;
+        return false;
+    }
+
+    const QStringList segments = dir.entryList({QString("*") + SEGMENT_SUFFIX}, QDir::Files, QDir::Name);
+    m_epoch = readEpoch(segments);
+    bool opened = segments.isEmpty() ? createSegment(0)
+                                     : openSegment(dir.filePath(segments.last()));
+    if (!opened)
+        return false;
+
+    if (m_segmentRecords >= RECORDS_PER_SEGMENT)
+        rotate();
+
+    flushTimer->start();
+    syncTimer->start();
+    qDebug() << "Measurement log opened at" << m_file.fileName() << "next sequence" << m_nextSequence
+             << "epoch" << m_epoch;
+    return true;
+}
+
+void MeasurementLog::close()
+{
+    if (!m_file.isOpen())
+        return;
+
+    flushTimer->stop();
+    syncTimer->stop();
+    flush();
+    sync();
+    m_file.close();
+}
+
+bool MeasurementLog::isOpen() const
+{
+    return m_file.isOpen();
+}
+
+quint32 MeasurementLog::append(qint64 timestamp, float rawAdc, float filtered, float bac, float r0, quint16 flags)
+{
+    if (!m_file.isOpen())
+        return m_nextSequence;
+
+    LogRecord record;
+    record.sequence = m_nextSequence++;
+    record.timestamp = timestamp;
+    record.rawAdc = rawAdc;
+    record.filtered = filtered;
+    record.bac = bac;
+    record.r0 = r0;
+    record.flags = flags;
+    record.checksum = recordChecksum(record);
+
+    m_buffer.append(reinterpret_cast<const char*>(&record), sizeof(record));
+    m_segmentRecords++;
+
+    if (m_buffer.size() >= BLOCK_SIZE)
+        flush();
+    if (m_segmentRecords >= RECORDS_PER_SEGMENT)
+        rotate();
+
+    return record.sequence;
+}
+
+void MeasurementLog::flush()
+{
+    if (m_buffer.isEmpty() || !m_file.isOpen())
+        return;
+
+    if (m_file.write(m_buffer) != m_buffer.size())
+        qWarning() << "Measurement log write failed:" << m_file.errorString();
+
+    m_file.flush();
+    m_buffer.clear();
+    m_dirty = true;
+}
+
+void MeasurementLog::sync()
+{
+    if (!m_dirty || !m_file.isOpen())
+        return;
+
+    ::fdatasync(m_file.handle());
+    m_dirty = false;
+}
+
+QString MeasurementLog::directory() const
+{
+    return m_directory;
+}
+
+quint32 MeasurementLog::nextSequence() const
+{
+    return m_nextSequence;
+}
+
+quint32 MeasurementLog::epoch() const
+{
+    return m_epoch;
+}
+
+quint16 MeasurementLog::recordChecksum(const LogRecord &record)
+{
+    return logRecordChecksum(record);
+}
+
+bool MeasurementLog::isValid(const LogRecord &record)
+{
+    return record.checksum == recordChecksum(record);
+}
+
+QString MeasurementLog::segmentName(quint32 firstSequence)
+{
+    return QString("%1%2").arg(firstSequence, 10, 10, QChar('0')).arg(SEGMENT_SUFFIX);
+}
+
+quint32 MeasurementLog::readEpoch(const QStringList &segments) const
+{
+    // Segments written before the epoch existed carry 0 in its place
+    QDir dir(m_directory);
+    for (const QString &name : segments) {
+        QFile file(dir.filePath(name));
+        LogSegmentHeader header;
+        if (file.open(QIODevice::ReadOnly)
+            && file.read(reinterpret_cast<char*>(&header), sizeof(header)) == sizeof(header)
+            && memcmp(header.magic, MAGIC, sizeof(MAGIC)) == 0)
+            return header.epoch;
+    }
+
+    quint32 epoch = 0;
+    while (epoch == 0)
+        epoch = QRandomGenerator::system()->generate();
+    qDebug() << "Measurement log starts from scratch with epoch" << epoch;
+    return epoch;
+}
+
+bool MeasurementLog::openSegment(const QString &path)
+{
+    m_file.setFileName(path);
+    if (!m_file.open(QIODevice::ReadWrite)) {
+        qWarning() << "Can not open measurement log segment" << path << m_file.errorString();
+        return false;
+    }
+
+    LogSegmentHeader header;
+    if (m_file.read(reinterpret_cast<char*>(&header), sizeof(header)) != sizeof(header)
+        || memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0
+        || header.recordSize != sizeof(LogRecord)) {
+        // The header of a freshly created segment was torn, start it over
+        quint32 firstSequence = QFileInfo(path).completeBaseName().toUInt();
+        m_file.close();
+        return createSegment(firstSequence);
+    }
+
+    // Records are addressed by position, so a damaged one in the middle stays
+    // where it is and readers skip it. Only what follows the last good record
+    // is a torn tail.
+    const qint64 recordCount = (m_file.size() - static_cast<qint64>(sizeof(header))) / sizeof(LogRecord);
+    qint64 goodRecords = 0;
+    qint64 damaged = 0;
+
+    LogRecord record;
+    for (qint64 i = 0; i < recordCount; ++i) {
+        if (m_file.read(reinterpret_cast<char*>(&record), sizeof(record)) != sizeof(record))
+            break;
+        if (isValid(record) && record.sequence == header.firstSequence + i) {
+            damaged += i - goodRecords;
+            goodRecords = i + 1;
+        }
+    }
+
+    if (damaged > 0)
+        qWarning() << "Measurement log" << path << "has" << damaged << "damaged records, skipped by readers";
+
+    const qint64 validSize = sizeof(header) + goodRecords * sizeof(LogRecord);
+    if (goodRecords < recordCount) {
+        // Whole records that do not check out are more than a torn write,
+        // keep a copy of the segment before cutting them off
+        const QString copy = path + DAMAGED_SUFFIX;
+        QFile::remove(copy);
+        if (!QFile::copy(path, copy)) {
+            qWarning() << "Can not keep a copy of damaged measurement log" << path << "- appending after it";
+            m_file.close();
+            return createSegment(header.firstSequence + recordCount);
+        }
+        qWarning() << "Measurement log kept a copy of" << path << "as" << copy;
+        removeOldSegments();
+    }
+    if (validSize != m_file.size()) {
+        qWarning() << "Measurement log truncated torn tail of" << path << "at" << validSize << "bytes";
+        m_file.resize(validSize);
+    }
+
+    m_nextSequence = header.firstSequence + goodRecords;
+    m_segmentRecords = static_cast<int>(goodRecords);
+    m_file.seek(validSize);
+    return true;
+}
+
+bool MeasurementLog::createSegment(quint32 firstSequence)
+{
+    m_file.setFileName(QDir(m_directory).filePath(segmentName(firstSequence)));
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate)) {
+        qWarning() << "Can not create measurement log segment" << m_file.fileName() << m_file.errorString();
+        return false;
+    }
+
+    LogSegmentHeader header{};
+    memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = VERSION;
+    header.recordSize = sizeof(LogRecord);
+    header.firstSequence = firstSequence;
+    header.epoch = m_epoch;
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.flush();
+
+    m_nextSequence = firstSequence;
+    m_segmentRecords = 0;
+    m_dirty = true;
+    return true;
+}
+
+void MeasurementLog::rotate()
+{
+    flush();
+    sync();
+    m_file.close();
+
+    if (createSegment(m_nextSequence))
+        removeOldSegments();
+}
+
+void MeasurementLog::removeOldSegments()
+{
+    QDir dir(m_directory);
+    QStringList segments = dir.entryList({QString("*") + SEGMENT_SUFFIX}, QDir::Files, QDir::Name);
+    QStringList copies = dir.entryList({QString("*") + SEGMENT_SUFFIX + DAMAGED_SUFFIX}, QDir::Files, QDir::Name);
+
+    // Copies of damaged segments are as large as the segments and share their budget
+    while (copies.size() > MAX_DAMAGED_COPIES) {
+        dir.remove(copies.takeFirst());
+    }
+    while (segments.size() + copies.size() > MAX_SEGMENTS) {
+        dir.remove(segments.takeFirst());
+    }
+
+    // A copy goes with its segment, names sort by first sequence
+    while (!copies.isEmpty() && (segments.isEmpty() || copies.first() < segments.first())) {
+        dir.remove(copies.takeFirst());
+    }
+}
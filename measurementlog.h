@@ -0,0 +1,72 @@
+#ifndef MEASUREMENTLOG_H
+#define MEASUREMENTLOG_H
+
+#include <QObject>
+#include <QFile>
+#include <QTimer>
+#include <QByteArray>
+#include <QString>
+#include <QStringList>
+#include "logrecord.h"
+
+// Append-only session log made of fixed-size segments. Records are
+// collected in a block buffer and written a block at a time; the file is
+// only synced on rotation and on a slow timer. A torn tail left by a
+// crash is detected by the record checksum and truncated on open; a
+// segment losing whole records that way is copied aside first. Every
+// segment header carries the epoch of the log, drawn anew when the log
+// starts from scratch.
+class MeasurementLog : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr char MAGIC[4] = {'A', 'M', 'L', 'G'};
+    static constexpr quint16 VERSION = 1;
+    static constexpr int BLOCK_SIZE = 4096;                 // Bytes buffered before a write
+    static constexpr int RECORDS_PER_SEGMENT = 32768;       // 1 MB per segment
+    static constexpr int MAX_SEGMENTS = 64;                 // Oldest segments are removed beyond this
+    static constexpr int MAX_DAMAGED_COPIES = 4;            // Count toward MAX_SEGMENTS
+    static constexpr int FLUSH_INTERVAL = 10000;            // Write a partial block at least this often
+    static constexpr int SYNC_INTERVAL = 60000;             // fdatasync at least this often
+    static constexpr const char *SEGMENT_SUFFIX = ".aml";
+    static constexpr const char *DAMAGED_SUFFIX = ".damaged";   // Copy kept before a tail is cut
+
+    explicit MeasurementLog(const QString &directory, QObject *parent = nullptr);
+    ~MeasurementLog();
+
+    bool open();
+    void close();
+    bool isOpen() const;
+
+    quint32 append(qint64 timestamp, float rawAdc, float filtered, float bac, float r0, quint16 flags = 0);
+    void flush();
+    void sync();
+
+    QString directory() const;
+    quint32 nextSequence() const;
+    quint32 epoch() const;
+
+    static quint16 recordChecksum(const LogRecord &record);
+    static bool isValid(const LogRecord &record);
+    static QString segmentName(quint32 firstSequence);
+
+private:
+    quint32 readEpoch(const QStringList &segments) const;
+    bool openSegment(const QString &path);
+    bool createSegment(quint32 firstSequence);
+    void rotate();
+    void removeOldSegments();
+
+    QString m_directory;
+    QFile m_file;
+    QByteArray m_buffer;
+    QTimer *flushTimer;
+    QTimer *syncTimer;
+    quint32 m_nextSequence = 0;
+    quint32 m_epoch = 0;
+    int m_segmentRecords = 0;
+    bool m_dirty = false;
+};
+
+#endif // MEASUREMENTLOG_H
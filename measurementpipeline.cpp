@@ -0,0 +1,153 @@
+#include "measurementpipeline.h"
+#include "metrics.h"
+#include <QElapsedTimer>
+#include <QThread>
+#include <algorithm>
+
+MeasurementPipeline::MeasurementPipeline(AdcSource *source)
+    : m_source(source)
+{
+}
+
+int MeasurementPipeline::readRaw(int channel)
+{
+    Metrics &metrics = Metrics::instance();
+    StageTimer timer(metrics.adcRead);
+    int rawValue = m_source ? m_source->read(channel) : -1;
+    metrics.samplesRead.fetch_add(1, std::memory_order_relaxed);
+    if (rawValue < 0)
+        metrics.adcErrors.fetch_add(1, std::memory_order_relaxed);
+    return rawValue;
+}
+
+int MeasurementPipeline::readSample(int channel)
+{
+    return qMax(0, readRaw(channel));  // Prevent negative readings
+}
+
+float MeasurementPipeline::acquire(int samples, int intervalMs)
+{
+    Metrics &metrics = Metrics::instance();
+    StageTimer timer(metrics.stage(MetricsSummary::Acquisition));
+    if (samples <= 0)
+        return 0.0f;
+
+    // Blocks are a second apart, the window only spans one
+    const quint64 rejectedBefore = m_hampel.rejected();
+    m_hampel.reset();
+    m_faults.beginBlock(0);
+
+    // Faulty samples never reach the Hampel window. Their slots take the
+    // window median, or the last good sample, so the decimator still sees
+    // evenly spaced samples and keeps its notch and group delay.
+    m_block.resize(samples);
+    int good = 0;
+    float last = 0.0f;
+    QElapsedTimer elapsed;
+    elapsed.start();
+    for (int x = 0; x < samples; x++) {
+        int sample = readRaw(0);
+        if (m_faults.check(sample) == SensorFault::None) {
+            const float value = m_rejectOutliers ? m_hampel.filter(sample) : sample;
+            if (good++ == 0)
+                std::fill(m_block.begin(), m_block.begin() + x, value);    // Faulty slots before it
+            m_block[x] = value;
+            last = value;
+        } else {
+            m_block[x] = m_rejectOutliers && good > 0 ? m_hampel.median() : last;
+        }
+        if (intervalMs > 0)
+            QThread::msleep(intervalMs);
+    }
+    metrics.samplesRejected.fetch_add(m_hampel.rejected() - rejectedBefore, std::memory_order_relaxed);
+    metrics.samplesFaulty.fetch_add(m_faults.endBlock().faulty, std::memory_order_relaxed);
+    if (good == 0)
+        return 0.0f;
+
+    // The filters are designed for the rate actually achieved, sleeps and
+    // conversion time make it lower than 1000 / intervalMs
+    double sampleRate = m_sampleRate;
+    if (sampleRate <= 0.0) {
+        qint64 nanoseconds = elapsed.nsecsElapsed();
+        sampleRate = nanoseconds > 0 ? samples * 1e9 / nanoseconds : 0.0;
+    }
+    return m_decimator.decimate(m_block.constData(), samples, sampleRate);
+}
+
+void MeasurementPipeline::setOutlierWindow(int window)
+{
+    m_rejectOutliers = window > 0;
+    if (m_rejectOutliers)
+        m_hampel = HampelFilter(window);
+}
+
+Measurement MeasurementPipeline::process(float average, double dt, float r0)
+{
+    StageTimer timer(Metrics::instance().stage(MetricsSummary::Filtering));
+    Measurement result;
+    result.raw = average;
+
+    // Without a positive time step the previous estimate is kept
+    if (dt > 0)
+        m_kalman.Update(average, m_measurementVariance, dt);
+    result.filtered = dt > 0 ? m_kalman.GetXAbs() : average;
+
+    // Calculate sensor voltage
+    result.volt = toVolt(result.filtered);
+
+    // A zero voltage or R0 would turn RS/R0 into inf or NaN on the wire
+    result.valid = result.volt > 0.0f && r0 > 0.0f;
+    if (!result.valid) {
+        result.ratio = 0.0f;
+        result.bac = 0.0f;
+        return result;
+    }
+
+    // Calculate RS
+    float RS = (SENSOR_VCC - result.volt) / result.volt;
+
+    // Calculate ratio RS/R0
+    result.ratio = RS / r0;
+
+    // Convert to mg/L based on datasheet curve
+    if (result.ratio > 20.0f) {
+        result.bac = 0.1f * (20.0f / result.ratio);
+    } else if (result.ratio < 3.0f) {
+        result.bac = 1.0f * (3.0f / result.ratio);
+    } else {
+        // Linear interpolation between 0.1 and 1.0 mg/L
+        result.bac = 0.1f + (20.0f - result.ratio) * (0.9f / 17.0f);
+    }
+    return result;
+}
+
+FilterState MeasurementPipeline::filterState() const
+{
+    return FilterState{m_kalman.GetXAbs(), m_kalman.GetXVel(),
+                       m_kalman.GetCovAbsAbs(), m_kalman.GetCovAbsVel(), m_kalman.GetCovVelVel()};
+}
+
+void MeasurementPipeline::restoreFilter(const FilterState &state)
+{
+    m_kalman.Restore(state.abs, state.vel, state.covAbsAbs, state.covAbsVel, state.covVelVel);
+}
+
+float MeasurementPipeline::toVolt(float value)
+{
+    return (value / VOLT_RESOLUTION) * ADS1115_VOLTAGE_RANGE;
+}
+
+float MeasurementPipeline::cleanAirR0(float average)
+{
+    float sensor_volt = toVolt(average);
+    if (sensor_volt <= 0)
+        return 0.0f;
+
+    float RS_air = (SENSOR_VCC - sensor_volt) / sensor_volt;
+    return RS_air / CLEAN_AIR_FACTOR;
+}
+
+void MeasurementPipeline::reset()
+{
+    m_kalman.Reset();
+}
@@ -0,0 +1,101 @@
+#ifndef MEASUREMENTPIPELINE_H
+#define MEASUREMENTPIPELINE_H
+
+#include "adcsource.h"
+#include "decimator.h"
+#include "faultdetector.h"
+#include "hampelfilter.h"
+#include "kalmanfilter.h"
+#include <QVector>
+
+struct Measurement {
+    float raw;          // Decimated ADC value
+    float filtered;     // Kalman filtered ADC value
+    float volt;         // Sensor voltage
+    float ratio;        // RS/R0
+    float bac;          // mg/L
+    bool valid;         // False if the voltage gives no finite RS/R0
+};
+
+// Kalman filter state, saved across restarts
+struct FilterState {
+    double abs;
+    double vel;
+    double covAbsAbs;
+    double covAbsVel;
+    double covVelVel;
+};
+
+// The processing chain of one reading, from raw ADC samples to mg/L:
+// fault detection, outlier rejection, decimation, Kalman filtering and the RS/R0 conversion. It has no
+// hardware or Qt event loop dependency so the daemon, the benchmarks and
+// tests all run the same code. Stages are timed into Metrics.
+class MeasurementPipeline
+{
+public:
+    static constexpr float VOLT_RESOLUTION = 32767.0f;    // 15-bit resolution for ADS1115
+    static constexpr float ADS1115_VOLTAGE_RANGE = 4.096f; // Using ±4.096V range
+    static constexpr float SENSOR_VCC = 5.0f;             // MQ3 sensor powered by 5V
+    static constexpr float CLEAN_AIR_FACTOR = 70.0f;      // RS/R0 ratio in clean air
+
+    explicit MeasurementPipeline(AdcSource *source = nullptr);
+
+    void setSource(AdcSource *source) { m_source = source; }
+    AdcSource *source() const { return m_source; }
+
+    // Single conversion, negative values are counted as errors and clamped to 0
+    int readSample(int channel);
+
+    // samples conversions of channel 0, sleeping intervalMs between them.
+    // Faulty samples are replaced by the outlier median, the rest is cleaned
+    // of outliers and reduced to one value by the decimator. Check usable()
+    // before using it.
+    float acquire(int samples, int intervalMs = 0);
+
+    // Fault summary of the last acquire(), usable when its kind is None
+    const SensorFault &fault() const { return m_faults.status(); }
+    bool usable() const { return m_faults.usable(); }
+
+    void setDecimator(const Decimator::Config &config) { m_decimator.setConfig(config); }
+    const Decimator::Config &decimator() const { return m_decimator.config(); }
+
+    // Hampel window in samples, 0 lets every sample through
+    void setOutlierWindow(int window);
+    quint64 rejectedSamples() const { return m_hampel.rejected(); }
+
+    // Rate the decimator is designed for, 0 measures it on every acquire()
+    void setSampleRate(double rate) { m_sampleRate = rate; }
+
+    void setVariances(double acceleration, double measurement)
+    {
+        m_kalman.SetAccelerationVariance(acceleration);
+        m_measurementVariance = measurement;
+    }
+
+    // Filters a decimated value and converts it, dt is seconds since the last call
+    Measurement process(float average, double dt, float r0);
+
+    FilterState filterState() const;
+    void restoreFilter(const FilterState &state);
+
+    static float toVolt(float value);
+    static float cleanAirR0(float average);
+
+    void reset();
+
+private:
+    // Conversion as returned by the source, negative on a read error
+    int readRaw(int channel);
+
+    AdcSource *m_source;
+    FaultDetector m_faults;
+    HampelFilter m_hampel;
+    bool m_rejectOutliers = true;
+    Decimator m_decimator;
+    QVector<float> m_block;     // Samples of the current acquire()
+    double m_sampleRate = 0.0;
+    KalmanFilter m_kalman{0.1};
+    double m_measurementVariance = 0.5;
+};
+
+#endif // MEASUREMENTPIPELINE_H
@@ -0,0 +1,188 @@
+#include "metrics.h"
+#include <QString>
+#include <cmath>
+#include <limits>
+
+double LatencyHistogram::mean() const
+{
+    quint64 count = this->count();
+    return count ? static_cast<double>(m_sum.load(std::memory_order_relaxed)) / count : 0.0;
+}
+
+quint64 LatencyHistogram::percentile(double percent) const
+{
+    quint64 count = this->count();
+    if (count == 0)
+        return 0;
+
+    quint64 rank = static_cast<quint64>(std::ceil(percent / 100.0 * count));
+    rank = qBound<quint64>(1, rank, count);
+
+    quint64 seen = 0;
+    for (int i = 0; i < BUCKETS; ++i) {
+        seen += m_counts[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return qMin(bucketUpperBound(i), max());
+    }
+    return max();
+}
+
+void LatencyHistogram::reset()
+{
+    for (auto &count : m_counts) {
+        count.store(0, std::memory_order_relaxed);
+    }
+    m_count.store(0, std::memory_order_relaxed);
+    m_sum.store(0, std::memory_order_relaxed);
+    m_max.store(0, std::memory_order_relaxed);
+}
+
+int LatencyHistogram::bucketIndex(quint64 value)
+{
+    if (value < SUB_BUCKETS)
+        return static_cast<int>(value);
+
+    // Position of the highest set bit selects the power of two, the next
+    // SUB_BUCKET_BITS bits select the linear bucket inside it
+    int magnitude = 63 - __builtin_clzll(value);
+    int shift = magnitude - SUB_BUCKET_BITS;
+    int sub = static_cast<int>((value >> shift) & (SUB_BUCKETS - 1));
+    return SUB_BUCKETS + shift * SUB_BUCKETS + sub;
+}
+
+quint64 LatencyHistogram::bucketUpperBound(int index)
+{
+    if (index < SUB_BUCKETS)
+        return index;
+
+    int shift = (index - SUB_BUCKETS) / SUB_BUCKETS;
+    quint64 sub = (index - SUB_BUCKETS) % SUB_BUCKETS;
+    quint64 lower = (SUB_BUCKETS + sub) << shift;
+    quint64 width = quint64(1) << shift;
+    return lower + width - 1;
+}
+
+Metrics &Metrics::instance()
+{
+    static Metrics metrics;
+    return metrics;
+}
+
+Metrics::Metrics()
+    : m_started(std::chrono::steady_clock::now())
+{
+}
+
+const char *Metrics::stageName(Stage stage)
+{
+    switch (stage) {
+    case MetricsSummary::Acquisition:
+        return "acquisition";
+    case MetricsSummary::Filtering:
+        return "filtering";
+    case MetricsSummary::Encoding:
+        return "encoding";
+    case MetricsSummary::Send:
+        return "send";
+    default:
+        return "unknown";
+    }
+}
+
+void Metrics::markReading()
+{
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    m_lastReading.store(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(), std::memory_order_relaxed);
+    measurements.fetch_add(1, std::memory_order_relaxed);
+}
+
+qint64 Metrics::stalenessMs() const
+{
+    qint64 last = m_lastReading.load(std::memory_order_relaxed);
+    if (last == 0)
+        return -1;
+
+    auto now = std::chrono::steady_clock::now().time_since_epoch();
+    return (std::chrono::duration_cast<std::chrono::nanoseconds>(now).count() - last) / 1000000;
+}
+
+void Metrics::reset()
+{
+    adcRead.reset();
+    gpioEdge.reset();
+    for (auto &stage : m_stages) {
+        stage.reset();
+    }
+    for (auto *counter : {&samplesRead, &adcErrors, &samplesRejected, &samplesFaulty, &measurements, &framesSent, &framesDropped, &bytesSent}) {
+        counter->store(0, std::memory_order_relaxed);
+    }
+    m_lastReading.store(0, std::memory_order_relaxed);
+}
+
+static StageSummary summarize(const LatencyHistogram &histogram)
+{
+    StageSummary summary;
+    summary.count = static_cast<quint32>(histogram.count());
+    summary.p50 = histogram.percentile(50) / 1000.0f;
+    summary.p99 = histogram.percentile(99) / 1000.0f;
+    summary.max = histogram.max() / 1000.0f;
+    return summary;
+}
+
+MetricsSummary Metrics::summary() const
+{
+    MetricsSummary summary;
+    auto uptime = std::chrono::steady_clock::now() - m_started;
+    summary.uptime = std::chrono::duration_cast<std::chrono::seconds>(uptime).count();
+    summary.measurements = measurements.load(std::memory_order_relaxed);
+    summary.framesSent = framesSent.load(std::memory_order_relaxed);
+    summary.framesDropped = framesDropped.load(std::memory_order_relaxed);
+    summary.adcErrors = adcErrors.load(std::memory_order_relaxed);
+    qint64 staleness = stalenessMs();
+    summary.staleness = staleness < 0 ? std::numeric_limits<quint32>::max() : static_cast<quint32>(staleness);
+    summary.adcRead = summarize(adcRead);
+    for (int i = 0; i < MetricsSummary::StageCount; ++i) {
+        summary.stages[i] = summarize(m_stages[i]);
+    }
+    return summary;
+}
+
+QByteArray Metrics::textReport() const
+{
+    QString report;
+    auto counter = [&report](const char *name, quint64 value) {
+        report += QString("alcoholmeter_%1 %2\n").arg(name).arg(value);
+    };
+    auto histogram = [&report](const QString &labels, const LatencyHistogram &histogram) {
+        for (double quantile : {50.0, 90.0, 99.0, 99.9}) {
+            report += QString("alcoholmeter_latency_us{%1,quantile=\"%2\"} %3\n")
+                          .arg(labels).arg(quantile / 100.0).arg(histogram.percentile(quantile) / 1000.0);
+        }
+        report += QString("alcoholmeter_latency_us_max{%1} %2\n").arg(labels).arg(histogram.max() / 1000.0);
+        report += QString("alcoholmeter_latency_us_mean{%1} %2\n").arg(labels).arg(histogram.mean() / 1000.0);
+        report += QString("alcoholmeter_latency_count{%1} %2\n").arg(labels).arg(histogram.count());
+    };
+
+    auto uptime = std::chrono::steady_clock::now() - m_started;
+    counter("uptime_seconds", std::chrono::duration_cast<std::chrono::seconds>(uptime).count());
+    counter("samples_read_total", samplesRead.load(std::memory_order_relaxed));
+    counter("adc_errors_total", adcErrors.load(std::memory_order_relaxed));
+    counter("samples_rejected_total", samplesRejected.load(std::memory_order_relaxed));
+    counter("samples_faulty_total", samplesFaulty.load(std::memory_order_relaxed));
+    counter("measurements_total", measurements.load(std::memory_order_relaxed));
+    counter("frames_sent_total", framesSent.load(std::memory_order_relaxed));
+    counter("frames_dropped_total", framesDropped.load(std::memory_order_relaxed));
+    counter("bytes_sent_total", bytesSent.load(std::memory_order_relaxed));
+    report += QString("alcoholmeter_reading_staleness_ms %1\n").arg(stalenessMs());
+    report += QString("alcoholmeter_startup_ready_ms %1\n").arg(startupReadyMs.load(std::memory_order_relaxed));
+    report += QString("alcoholmeter_startup_first_reading_ms %1\n").arg(startupFirstReadingMs.load(std::memory_order_relaxed));
+    report += QString("alcoholmeter_boot_first_reading_ms %1\n").arg(bootFirstReadingMs.load(std::memory_order_relaxed));
+
+    histogram("stage=\"adc_read\"", adcRead);
+    histogram("stage=\"gpio_edge\"", gpioEdge);
+    for (int i = 0; i < MetricsSummary::StageCount; ++i) {
+        auto stage = static_cast<Stage>(i);
+        histogram(QString("stage=\"%1\"").arg(stageName(stage)), m_stages[i]);
+    }
+    return report.toUtf8();
+}
@@ -0,0 +1,114 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <QtGlobal>
+#include <QByteArray>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include "metricssummary.h"
+
+// HDR-style latency histogram. Values below SUB_BUCKETS are counted
+// exactly, above that every power of two is split into SUB_BUCKETS linear
+// buckets, which bounds the relative error to 1 / SUB_BUCKETS over the
+// whole 64-bit range with a fixed 8 KB footprint. Recording is a couple of
+// relaxed atomic increments, so readers on other threads never block it.
+class LatencyHistogram
+{
+public:
+    static constexpr int SUB_BUCKET_BITS = 4;
+    static constexpr int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+    static constexpr int BUCKETS = SUB_BUCKETS * (64 - SUB_BUCKET_BITS + 1);
+
+    void record(quint64 value)
+    {
+        m_counts[bucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+        m_count.fetch_add(1, std::memory_order_relaxed);
+        m_sum.fetch_add(value, std::memory_order_relaxed);
+        quint64 max = m_max.load(std::memory_order_relaxed);
+        while (value > max && !m_max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {
+        }
+    }
+
+    quint64 count() const { return m_count.load(std::memory_order_relaxed); }
+    quint64 max() const { return m_max.load(std::memory_order_relaxed); }
+    double mean() const;
+    quint64 percentile(double percent) const;
+    void reset();
+
+    static int bucketIndex(quint64 value);
+    static quint64 bucketUpperBound(int index);
+
+private:
+    std::array<std::atomic<quint64>, BUCKETS> m_counts{};
+    std::atomic<quint64> m_count{0};
+    std::atomic<quint64> m_sum{0};
+    std::atomic<quint64> m_max{0};
+};
+
+// Process wide counters and per-stage latency histograms of the daemon.
+// All latencies are recorded in nanoseconds.
+class Metrics
+{
+public:
+    using Stage = MetricsSummary::Stage;
+
+    static Metrics &instance();
+
+    LatencyHistogram &stage(Stage stage) { return m_stages[stage]; }
+    const LatencyHistogram &stage(Stage stage) const { return m_stages[stage]; }
+    static const char *stageName(Stage stage);
+
+    void markReading();
+    qint64 stalenessMs() const;
+
+    MetricsSummary summary() const;
+    QByteArray textReport() const;
+
+    // Clears histograms and counters, e.g. after a benchmark warm-up
+    void reset();
+
+    LatencyHistogram adcRead;
+    LatencyHistogram gpioEdge;              // From the edge timestamp to its handler
+    std::atomic<quint64> samplesRead{0};
+    std::atomic<quint64> adcErrors{0};
+    std::atomic<quint64> samplesRejected{0};  // Replaced by the Hampel filter
+    std::atomic<quint64> samplesFaulty{0};    // Dropped by the fault detector
+    std::atomic<quint64> measurements{0};
+    std::atomic<quint64> framesSent{0};
+    std::atomic<quint64> framesDropped{0};
+    std::atomic<quint64> bytesSent{0};
+
+    // Start-up times in ms, -1 until known. Not cleared by reset().
+    std::atomic<qint64> startupReadyMs{-1};
+    std::atomic<qint64> startupFirstReadingMs{-1};
+    std::atomic<qint64> bootFirstReadingMs{-1};    // From kernel boot, the cold-boot figure
+
+private:
+    Metrics();
+
+    std::array<LatencyHistogram, MetricsSummary::StageCount> m_stages;
+    std::chrono::steady_clock::time_point m_started;
+    std::atomic<qint64> m_lastReading{0};  // steady clock ns, 0 before the first reading
+};
+
+// Records the lifetime of the scope into a histogram.
+class StageTimer
+{
+public:
+    explicit StageTimer(LatencyHistogram &histogram)
+        : m_histogram(histogram)
+        , m_start(std::chrono::steady_clock::now()) {}
+
+    ~StageTimer()
+    {
+        auto elapsed = std::chrono::steady_clock::now() - m_start;
+        m_histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+    }
+
+private:
+    LatencyHistogram &m_histogram;
+    std::chrono::steady_clock::time_point m_start;
+};
+
+#endif // METRICS_H
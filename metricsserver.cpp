@@ -0,0 +1,34 @@
+#include "metricsserver.h"
+#include "metrics.h"
+#include <QTcpSocket>
+#include <QDebug>
+
+MetricsServer::MetricsServer(QObject *parent) : QObject(parent)
+{
+    tcpServer = new QTcpServer(this);
+    connect(tcpServer, &QTcpServer::newConnection, this, &MetricsServer::onNewConnection);
+}
+
+bool MetricsServer::listen(quint16 port)
+{
+    if (!tcpServer->listen(QHostAddress::Any, port)) {
+        qWarning() << "Metrics server can not listen on port" << port << tcpServer->errorString();
+        return false;
+    }
+
+    qDebug() << "Serving metrics on port" << tcpServer->serverPort();
+    return true;
+}
+
+void MetricsServer::onNewConnection()
+{
+    while (QTcpSocket *socket = tcpServer->nextPendingConnection()) {
+        connect(socket, &QTcpSocket::disconnected, socket, &QObject::deleteLater);
+
+        const QByteArray report = Metrics::instance().textReport();
+        socket->write("HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n");
+        socket->write(QByteArray("Content-Length: ") + QByteArray::number(report.size()) + "\r\n\r\n");
+        socket->write(report);
+        socket->disconnectFromHost();
+    }
+}
@@ -0,0 +1,28 @@
+#ifndef METRICSSERVER_H
+#define METRICSSERVER_H
+
+#include <QObject>
+#include <QTcpServer>
+
+// Plain text metrics endpoint. Every connection gets the current
+// Metrics::textReport() wrapped in a minimal HTTP response, so it can be
+// read with curl, a browser or nc.
+class MetricsServer : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr quint16 DEFAULT_PORT = 9105;
+
+    explicit MetricsServer(QObject *parent = nullptr);
+
+    bool listen(quint16 port = DEFAULT_PORT);
+
+private slots:
+    void onNewConnection();
+
+private:
+    QTcpServer *tcpServer;
+};
+
+#endif // METRICSSERVER_H
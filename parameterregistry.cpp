@@ -0,0 +1,173 @@
+#include "parameterregistry.h"
+#include "ads1115adcsource.h"
+#include <QDebug>
+#include <QFileInfo>
+#include <QFileSystemWatcher>
+#include <QSettings>
+#include <cmath>
+
+const ParameterRegistry::Descriptor ParameterRegistry::descriptors[] = {
+    {ParamAccelVariance, "kalman/accel_variance", 1e-6, 100.0, &Parameters::accelVariance, nullptr},
+    {ParamMeasurementVariance, "kalman/measurement_variance", 1e-6, 100.0, &Parameters::measurementVariance, nullptr},
+    {ParamReadSamples, "acquisition/samples", 1, 1000, nullptr, &Parameters::readSamples},
+    {ParamSampleInterval, "acquisition/sample_interval_ms", 0, 100, nullptr, &Parameters::sampleInterval},
+    {ParamMeasurementInterval, "measurement/interval_ms", 100, 60000, nullptr, &Parameters::measurementInterval},
+    {ParamWarmupTime, "measurement/warmup_s", 0, 600, nullptr, &Parameters::warmupTime},
+};
+
+ParameterRegistry::ParameterRegistry(const QString &fileName, QObject *parent)
+    : QObject(parent)
+    , m_fileName(QFileInfo(fileName).absoluteFilePath())
+{
+    // Editors and QSettings replace the file, so the directory is watched too
+    m_watcher = new QFileSystemWatcher(this);
+    connect(m_watcher, &QFileSystemWatcher::fileChanged, this, &ParameterRegistry::onFileChanged);
+    connect(m_watcher, &QFileSystemWatcher::directoryChanged, this, &ParameterRegistry::onFileChanged);
+    watch();
+}
+
+const ParameterRegistry::Descriptor *ParameterRegistry::find(quint8 id)
+{
+    for (const Descriptor &descriptor : descriptors) {
+        if (descriptor.id == id)
+            return &descriptor;
+    }
+    return nullptr;
+}
+
+double ParameterRegistry::read(const Parameters &parameters, const Descriptor &descriptor)
+{
+    return descriptor.real ? parameters.*descriptor.real : parameters.*descriptor.integer;
+}
+
+void ParameterRegistry::write(Parameters &parameters, const Descriptor &descriptor, double value)
+{
+    if (descriptor.real)
+        parameters.*descriptor.real = value;
+    else
+        parameters.*descriptor.integer = static_cast<int>(std::lround(value));
+}
+
+qint64 ParameterRegistry::acquisitionTime(const Parameters &parameters, int sampleInterval)
+{
+    const qint64 conversion = Ads1115AdcSource::conversionPeriod(Ads1115AdcSource::Sps860).count();
+    return qint64(parameters.readSamples) * (sampleInterval * 1000 + conversion);
+}
+
+int ParameterRegistry::calibrationInterval(const Parameters &parameters)
+{
+    const qint64 conversion = Ads1115AdcSource::conversionPeriod(Ads1115AdcSource::Sps860).count();
+    const qint64 perSample = qint64(parameters.measurementInterval) * 1000 / qMax(parameters.readSamples, 1);
+    return static_cast<int>(qBound<qint64>(0, (perSample - conversion) / 1000, CALIBRATION_SAMPLE_INTERVAL));
+}
+
+bool ParameterRegistry::fitsInterval(const Parameters &parameters)
+{
+    const qint64 budget = qint64(parameters.measurementInterval) * 1000;
+    return acquisitionTime(parameters, parameters.sampleInterval) <= budget
+           && acquisitionTime(parameters, calibrationInterval(parameters)) <= budget;
+}
+
+bool ParameterRegistry::load()
+{
+    if (!QFileInfo::exists(m_fileName))
+        return true;
+
+    QSettings settings(m_fileName, QSettings::IniFormat);
+    if (settings.status() != QSettings::NoError) {
+        qWarning() << "Can not read parameters from" << m_fileName;
+        return false;
+    }
+
+    Parameters loaded;
+    for (const Descriptor &descriptor : descriptors) {
+        const QVariant value = settings.value(descriptor.key);
+        if (!value.isValid())
+            continue;
+
+        bool ok = false;
+        const double number = value.toDouble(&ok);
+        if (!ok || number < descriptor.minimum || number > descriptor.maximum) {
+            qWarning() << "Parameter" << descriptor.key << "=" << value.toString()
+                       << "is out of range, keeping the running parameters";
+            return false;
+        }
+        write(loaded, descriptor, number);
+    }
+
+    if (!fitsInterval(loaded)) {
+        qWarning() << "Reading" << loaded.readSamples << "samples takes" << acquisitionTime(loaded, loaded.sampleInterval) / 1000
+                   << "ms, longer than the" << loaded.measurementInterval
+                   << "ms interval, keeping the running parameters";
+        return false;
+    }
+
+    apply(loaded);
+    return true;
+}
+
+ParameterValue ParameterRegistry::get(quint8 id) const
+{
+    ParameterValue reply{id, ParameterValue::Ok, 0.0f};
+    const Descriptor *descriptor = find(id);
+    if (descriptor)
+        reply.value = static_cast<float>(read(m_current, *descriptor));
+    else
+        reply.status = ParameterValue::UnknownId;
+    return reply;
+}
+
+ParameterValue ParameterRegistry::set(quint8 id, float value)
+{
+    const Descriptor *descriptor = find(id);
+    if (!descriptor)
+        return ParameterValue{id, ParameterValue::UnknownId, 0.0f};
+    // The new value must leave time for a whole reading, the others stay as they are
+    const bool inRange = std::isfinite(value) && value >= descriptor->minimum && value <= descriptor->maximum;
+    Parameters updated = m_current;
+    if (inRange)
+        write(updated, *descriptor, value);
+    if (!inRange || !fitsInterval(updated)) {
+        ParameterValue reply = get(id);
+        reply.status = ParameterValue::OutOfRange;
+        return reply;
+    }
+
+    apply(updated);
+
+    QSettings settings(m_fileName, QSettings::IniFormat);
+    settings.setValue(descriptor->key, read(m_current, *descriptor));
+    settings.sync();
+    if (settings.status() != QSettings::NoError)
+        qWarning() << "Can not save parameter" << descriptor->key << "to" << m_fileName;
+    return get(id);
+}
+
+void ParameterRegistry::apply(const Parameters &parameters)
+{
+    bool different = false;
+    for (const Descriptor &descriptor : descriptors) {
+        different |= read(parameters, descriptor) != read(m_current, descriptor);
+    }
+    if (!different)
+        return;
+
+    m_current = parameters;
+    qDebug() << "Parameters updated";
+    emit changed(m_current);
+}
+
+void ParameterRegistry::onFileChanged()
+{
+    watch();
+    load();
+}
+
+void ParameterRegistry::watch()
+{
+    const QString directory = QFileInfo(m_fileName).absolutePath();
+    if (!m_watcher->directories().contains(directory))
+        m_watcher->addPath(directory);
+    if (QFileInfo::exists(m_fileName) && !m_watcher->files().contains(m_fileName))
+        m_watcher->addPath(m_fileName);
+}
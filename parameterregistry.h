@@ -0,0 +1,87 @@
+#ifndef PARAMETERREGISTRY_H
+#define PARAMETERREGISTRY_H
+
+#include <QObject>
+#include <QString>
+#include "parametervalue.h"
+
+class QFileSystemWatcher;
+
+// One consistent set of tuning values. Defaults are the values the daemon
+// was tuned with.
+struct Parameters {
+    double accelVariance = 0.1;
+    double measurementVariance = 0.5;
+    int readSamples = 100;
+    int sampleInterval = 2;             // ms
+    int measurementInterval = 1000;     // ms
+    int warmupTime = 5;                 // s
+};
+
+// Parameters loaded from an ini file and kept in sync with it. The file is
+// watched and reloaded when it changes. Values written over the protocol
+// are checked and saved back to it. A reload only applies if every value
+// in the file is in range, so the daemon never runs on a half-edited file.
+// Besides its own range, a set must leave time for all samples of a
+// reading, and of a calibration, within the measurement interval.
+//
+// changed() carries a complete snapshot. The registry lives on the event
+// loop thread like the measurement timer, so a snapshot is always applied
+// between two readings, never during one.
+class ParameterRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int CALIBRATION_SAMPLE_INTERVAL = 10;   // ms, longest spacing of calibration samples
+
+    explicit ParameterRegistry(const QString &fileName, QObject *parent = nullptr);
+
+    const Parameters &current() const { return m_current; }
+
+    // Reads the file, false if it has invalid values (missing keys keep
+    // their defaults)
+    bool load();
+
+    ParameterValue get(quint8 id) const;
+
+    // Checks, applies and saves one value, the reply carries the outcome
+    ParameterValue set(quint8 id, float value);
+
+    // ms between calibration samples, shortened from CALIBRATION_SAMPLE_INTERVAL
+    // so a calibration blocks the event loop no longer than a reading may
+    static int calibrationInterval(const Parameters &parameters);
+
+signals:
+    void changed(const Parameters &parameters);
+
+private slots:
+    void onFileChanged();
+
+private:
+    struct Descriptor {
+        quint8 id;
+        const char *key;
+        double minimum;
+        double maximum;
+        double Parameters::*real;       // One of the two is set
+        int Parameters::*integer;
+    };
+
+    static const Descriptor *find(quint8 id);
+    static double read(const Parameters &parameters, const Descriptor &descriptor);
+    static void write(Parameters &parameters, const Descriptor &descriptor, double value);
+    // Microseconds readSamples conversions take at the fastest rate
+    static qint64 acquisitionTime(const Parameters &parameters, int sampleInterval);
+    static bool fitsInterval(const Parameters &parameters);
+    void apply(const Parameters &parameters);
+    void watch();
+
+    static const Descriptor descriptors[];
+
+    QString m_fileName;
+    Parameters m_current;
+    QFileSystemWatcher *m_watcher;
+};
+
+#endif // PARAMETERREGISTRY_H
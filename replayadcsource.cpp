@@ -0,0 +1,79 @@
+#include "replayadcsource.h"
+#include <QFile>
+#include <QRandomGenerator>
+#include <QRegularExpression>
+#include <QDebug>
+#include <cmath>
+
+ReplayAdcSource::ReplayAdcSource(const QVector<int> &trace)
+    : m_trace(trace)
+{
+}
+
+bool ReplayAdcSource::load(const QString &fileName)
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text)) {
+        qWarning() << "Can not open ADC trace" << fileName << file.errorString();
+        return false;
+    }
+
+    static const QRegularExpression separators("[,;\\s]+");
+    QVector<int> trace;
+    while (!file.atEnd()) {
+        QString line = QString::fromUtf8(file.readLine());
+        int comment = line.indexOf('#');
+        if (comment >= 0)
+            line.truncate(comment);
+        const QStringList values = line.split(separators, Qt::SkipEmptyParts);
+        for (const QString &value : values) {
+            bool ok = false;
+            int raw = value.toInt(&ok);
+            if (ok)
+                trace.append(raw);
+        }
+    }
+
+    if (trace.isEmpty()) {
+        qWarning() << "ADC trace is empty" << fileName;
+        return false;
+    }
+
+    m_trace = trace;
+    m_position = 0;
+    return true;
+}
+
+void ReplayAdcSource::generate(int samples, quint32 seed, double glitchRate)
+{
+    // Roughly what an MQ3 on the ±4.096 V range shows: ~0.6 V in clean air
+    // rising to ~2.4 V for a few seconds when someone blows into it
+    constexpr double BASELINE = 4800.0;
+    constexpr double PULSE = 14000.0;
+    constexpr double NOISE = 40.0;
+    constexpr int PERIOD = 3000;
+
+    QRandomGenerator random(seed);
+    m_trace.resize(qMax(samples, 1));
+    for (int i = 0; i < m_trace.size(); ++i) {
+        double phase = (i % PERIOD) / double(PERIOD);
+        double pulse = phase < 0.3 ? std::sin(phase / 0.3 * M_PI) : 0.0;
+        double noise = (random.generateDouble() * 2.0 - 1.0) * NOISE;
+        m_trace[i] = qBound(0, static_cast<int>(BASELINE + PULSE * pulse + noise), 32767);
+        if (glitchRate > 0.0 && random.generateDouble() < glitchRate)
+            m_trace[i] = 0;
+    }
+    m_position = 0;
+}
+
+int ReplayAdcSource::read(int channel)
+{
+    Q_UNUSED(channel)
+    if (m_trace.isEmpty())
+        return -1;
+
+    int value = m_trace.at(m_position);
+    if (++m_position == m_trace.size())
+        m_position = 0;
+    return value;
+}
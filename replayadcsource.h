@@ -0,0 +1,32 @@
+#ifndef REPLAYADCSOURCE_H
+#define REPLAYADCSOURCE_H
+
+#include <QString>
+#include <QVector>
+#include "adcsource.h"
+
+// Plays back an ADC trace in a loop, on every channel. A trace is either
+// loaded from a text file with one raw value per line (or separated by
+// commas/whitespace, '#' starts a comment), or generated: a clean air
+// baseline with sensor noise and periodic breath pulses, optionally with
+// read glitches that come out of the driver as 0.
+class ReplayAdcSource : public AdcSource
+{
+public:
+    ReplayAdcSource() = default;
+    explicit ReplayAdcSource(const QVector<int> &trace);
+
+    bool load(const QString &fileName);
+    void generate(int samples, quint32 seed = 1, double glitchRate = 0.0);
+
+    int read(int channel) override;
+
+    const QVector<int> &trace() const { return m_trace; }
+    void rewind() { m_position = 0; }
+
+private:
+    QVector<int> m_trace;
+    int m_position = 0;
+};
+
+#endif // REPLAYADCSOURCE_H
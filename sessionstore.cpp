@@ -0,0 +1,224 @@
+#include "sessionstore.h"
+#include <QDir>
+#include <QDebug>
+#include <cstring>
+
+SessionStore::SessionStore(const QString &directory, QObject *parent)
+    : QObject(parent)
+    , m_directory(directory)
+{
+}
+
+SessionStore::~SessionStore()
+{
+    qDeleteAll(m_segments);
+}
+
+void SessionStore::refresh()
+{
+    QDir dir(m_directory);
+    const QStringList names = dir.entryList({QString("*") + MeasurementLog::SEGMENT_SUFFIX}, QDir::Files, QDir::Name);
+
+    QList<Segment*> segments;
+    segments.reserve(names.size());
+    for (const QString &name : names) {
+        const QString path = dir.filePath(name);
+        Segment *segment = nullptr;
+        for (int i = 0; i < m_segments.size(); ++i) {
+            if (m_segments.at(i)->file.fileName() == path) {
+                segment = m_segments.takeAt(i);
+                break;
+            }
+        }
+
+        if (!segment) {
+            segment = new Segment;
+            segment->file.setFileName(path);
+            if (!segment->file.open(QIODevice::ReadOnly)) {
+                qWarning() << "Can not open session segment" << path << segment->file.errorString();
+                delete segment;
+                continue;
+            }
+        }
+
+        if (mapSegment(segment))
+            segments.append(segment);
+        else
+            delete segment;
+    }
+
+    // Whatever is left was removed by log retention
+    qDeleteAll(m_segments);
+    m_segments = segments;
+}
+
+SessionStore::Cursor SessionStore::rangeCursor(qint64 from, qint64 to) const
+{
+    Cursor cursor;
+    cursor.from = from;
+    cursor.to = to;
+    cursor.sequence = firstSequence();
+
+    for (const Segment *segment : m_segments) {
+        if (segment->recordCount > 0 && segment->maxTimestamp >= from && segment->minTimestamp <= to) {
+            cursor.sequence = segment->firstSequence;
+            break;
+        }
+    }
+    return cursor;
+}
+
+SessionStore::Cursor SessionStore::sequenceCursor(quint32 sequence) const
+{
+    Cursor cursor;
+    cursor.sequence = sequence;
+    return cursor;
+}
+
+QByteArray SessionStore::next(Cursor &cursor, int maxRecords) const
+{
+    for (int s = segmentFor(cursor.sequence); s >= 0 && s < m_segments.size(); ++s) {
+        const Segment *segment = m_segments.at(s);
+        if (cursor.sequence < segment->firstSequence)
+            cursor.sequence = segment->firstSequence;
+
+        int record = cursor.sequence - segment->firstSequence;
+        if (record >= segment->recordCount)
+            continue;
+
+        if (segment->maxTimestamp < cursor.from || segment->minTimestamp > cursor.to) {
+            cursor.sequence = segment->firstSequence + segment->recordCount;
+            continue;
+        }
+
+        const LogRecord *records = segment->records();
+        while (record < segment->recordCount) {
+            const IndexBlock &block = segment->index.at(record / INDEX_STRIDE);
+            if (block.maxTimestamp < cursor.from || block.minTimestamp > cursor.to) {
+                record = (record / INDEX_STRIDE + 1) * INDEX_STRIDE;
+                continue;
+            }
+
+            qint64 timestamp = records[record].timestamp;
+            if (!isUsable(segment, record) || timestamp < cursor.from || timestamp > cursor.to) {
+                record++;
+                continue;
+            }
+
+            int start = record;
+            while (record < segment->recordCount && record - start < maxRecords) {
+                timestamp = records[record].timestamp;
+                if (!isUsable(segment, record) || timestamp < cursor.from || timestamp > cursor.to)
+                    break;
+                record++;
+            }
+
+            cursor.sequence = segment->firstSequence + record;
+            return QByteArray::fromRawData(reinterpret_cast<const char*>(records + start),
+                                           (record - start) * static_cast<int>(sizeof(LogRecord)));
+        }
+
+        cursor.sequence = segment->firstSequence + segment->recordCount;
+    }
+
+    return QByteArray();
+}
+
+int SessionStore::segmentCount() const
+{
+    return m_segments.size();
+}
+
+quint32 SessionStore::firstSequence() const
+{
+    return m_segments.isEmpty() ? 0 : m_segments.first()->firstSequence;
+}
+
+quint32 SessionStore::endSequence() const
+{
+    if (m_segments.isEmpty())
+        return 0;
+
+    const Segment *last = m_segments.last();
+    return last->firstSequence + last->recordCount;
+}
+
+bool SessionStore::mapSegment(Segment *segment)
+{
+    qint64 size = segment->file.size();
+    if (size == segment->mappedSize)
+        return true;
+
+    if (size < static_cast<qint64>(sizeof(LogSegmentHeader)))
+        return false;
+
+    if (segment->data)
+        segment->file.unmap(const_cast<uchar*>(segment->data));
+
+    segment->data = segment->file.map(0, size);
+    segment->mappedSize = segment->data ? size : 0;
+    if (!segment->data) {
+        qWarning() << "Can not map session segment" << segment->file.fileName() << segment->file.errorString();
+        return false;
+    }
+
+    const auto *header = reinterpret_cast<const LogSegmentHeader*>(segment->data);
+    if (memcmp(header->magic, MeasurementLog::MAGIC, sizeof(MeasurementLog::MAGIC)) != 0
+        || header->recordSize != sizeof(LogRecord)) {
+        qWarning() << "Invalid session segment header" << segment->file.fileName();
+        return false;
+    }
+
+    segment->firstSequence = header->firstSequence;
+    indexSegment(segment, segment->recordCount);
+    return true;
+}
+
+void SessionStore::indexSegment(Segment *segment, int fromRecord)
+{
+    int available = (segment->mappedSize - static_cast<qint64>(sizeof(LogSegmentHeader))) / sizeof(LogRecord);
+    const LogRecord *records = segment->records();
+
+    // A damaged record in the middle is left out of the index and skipped by
+    // next(), the count ends after the last good one
+    for (int record = fromRecord; record < available; ++record) {
+        const LogRecord &current = records[record];
+        if (!isUsable(segment, record))
+            continue;
+
+        int block = record / INDEX_STRIDE;
+        while (segment->index.size() <= block) {
+            segment->index.append({std::numeric_limits<qint64>::max(), std::numeric_limits<qint64>::min()});
+        }
+        IndexBlock &entry = segment->index[block];
+        entry.minTimestamp = qMin(entry.minTimestamp, current.timestamp);
+        entry.maxTimestamp = qMax(entry.maxTimestamp, current.timestamp);
+        segment->minTimestamp = qMin(segment->minTimestamp, current.timestamp);
+        segment->maxTimestamp = qMax(segment->maxTimestamp, current.timestamp);
+        segment->recordCount = record + 1;
+    }
+}
+
+bool SessionStore::isUsable(const Segment *segment, int record)
+{
+    const LogRecord &current = segment->records()[record];
+    return current.sequence == segment->firstSequence + record && MeasurementLog::isValid(current);
+}
+
+int SessionStore::segmentFor(quint32 sequence) const
+{
+    // Last segment starting at or before the sequence
+    int low = 0;
+    int high = m_segments.size() - 1;
+    int found = 0;
+    while (low <= high) {
+        int mid = (low + high) / 2;
+        if (m_segments.at(mid)->firstSequence <= sequence) {
+            found = mid;
+            low = mid + 1;
+        } else {
+            high = mid - 1;
+        }
+    }
+    return found;
+}
@@ -0,0 +1,77 @@
+#ifndef SESSIONSTORE_H
+#define SESSIONSTORE_H
+
+#include <QObject>
+#include <QFile>
+#include <QList>
+#include <QVector>
+#include <limits>
+#include "measurementlog.h"
+
+// Read side of the MeasurementLog. Segments are memory mapped and get a
+// sparse index holding the timestamp range of every INDEX_STRIDE records,
+// so a time-range query only touches the blocks that can match. Results
+// are returned as views into the mapping without copying records.
+class SessionStore : public QObject
+{
+    Q_OBJECT
+
+public:
+    static constexpr int INDEX_STRIDE = 256;
+
+    // Position in the log. Queries are resumed by handing the same cursor
+    // back to next(), which keeps working across refresh() and rotation.
+    struct Cursor {
+        quint32 sequence = 0;  // Next record to look at
+        qint64 from = std::numeric_limits<qint64>::min();
+        qint64 to = std::numeric_limits<qint64>::max();
+    };
+
+    explicit SessionStore(const QString &directory, QObject *parent = nullptr);
+    ~SessionStore();
+
+    void refresh();
+
+    Cursor rangeCursor(qint64 from, qint64 to) const;
+    Cursor sequenceCursor(quint32 sequence) const;
+
+    // Returns up to maxRecords consecutive matching records as a view into
+    // the mapped segment, or an empty array once the cursor is exhausted.
+    // The view stays valid until the next refresh().
+    QByteArray next(Cursor &cursor, int maxRecords) const;
+
+    int segmentCount() const;
+    quint32 firstSequence() const;
+    quint32 endSequence() const;
+
+private:
+    struct IndexBlock {
+        qint64 minTimestamp;
+        qint64 maxTimestamp;
+    };
+
+    struct Segment {
+        QFile file;
+        const uchar *data = nullptr;
+        qint64 mappedSize = 0;
+        quint32 firstSequence = 0;
+        int recordCount = 0;
+        qint64 minTimestamp = std::numeric_limits<qint64>::max();
+        qint64 maxTimestamp = std::numeric_limits<qint64>::min();
+        QVector<IndexBlock> index;
+
+        const LogRecord *records() const {
+            return reinterpret_cast<const LogRecord*>(data + sizeof(LogSegmentHeader));
+        }
+    };
+
+    bool mapSegment(Segment *segment);
+    void indexSegment(Segment *segment, int fromRecord);
+    static bool isUsable(const Segment *segment, int record);
+    int segmentFor(quint32 sequence) const;
+
+    QString m_directory;
+    QList<Segment*> m_segments;
+};
+
+#endif // SESSIONSTORE_H
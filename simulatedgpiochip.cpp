@@ -0,0 +1,62 @@
+#include "simulatedgpiochip.h"
+#include <QDebug>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+SimulatedGpioChip::SimulatedGpioChip(QObject *parent)
+    : GpioEventSource(parent)
+{
+    if (pipe2(m_pipe, O_NONBLOCK | O_CLOEXEC) < 0) {
+        qCritical() << "Can not create the simulated GPIO event pipe";
+        return;
+    }
+    m_notifier = new QSocketNotifier(m_pipe[0], QSocketNotifier::Read, this);
+    connect(m_notifier, &QSocketNotifier::activated, this, &SimulatedGpioChip::readEvents);
+}
+
+SimulatedGpioChip::~SimulatedGpioChip()
+{
+    delete m_notifier;
+    for (int fd : m_pipe) {
+        if (fd >= 0)
+            close(fd);
+    }
+}
+
+bool SimulatedGpioChip::watch(unsigned line)
+{
+    m_watched.insert(line);
+    return m_notifier != nullptr;
+}
+
+bool SimulatedGpioChip::value(unsigned line) const
+{
+    return m_values.value(line, false);
+}
+
+void SimulatedGpioChip::setValue(unsigned line, bool value)
+{
+    const bool previous = m_values.value(line, false);
+    m_values.insert(line, value);
+    if (previous == value || !m_watched.contains(line))
+        return;
+
+    // Writes below PIPE_BUF are atomic, an edge is never split
+    const GpioEdge edge{line, value, monotonicNow()};
+    if (write(m_pipe[1], &edge, sizeof(edge)) != sizeof(edge))
+        qWarning() << "Simulated GPIO edge dropped on line" << line;
+}
+
+void SimulatedGpioChip::readEvents()
+{
+    GpioEdge edges[16];
+    for (;;) {
+        const ssize_t size = read(m_pipe[0], edges, sizeof(edges));
+        if (size <= 0)
+            break;
+        for (size_t i = 0; i < size / sizeof(GpioEdge); ++i) {
+            emit edge(edges[i]);
+        }
+    }
+}
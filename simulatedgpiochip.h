@@ -0,0 +1,35 @@
+#ifndef SIMULATEDGPIOCHIP_H
+#define SIMULATEDGPIOCHIP_H
+
+#include <QHash>
+#include <QSet>
+#include <QSocketNotifier>
+#include "gpioeventsource.h"
+
+// In-process stand-in for a GPIO chip. setValue() drives an input like a
+// wire would; edges of watched lines are timestamped right there and travel
+// through a pipe and a QSocketNotifier, the same path kernel events take.
+class SimulatedGpioChip : public GpioEventSource
+{
+    Q_OBJECT
+
+public:
+    explicit SimulatedGpioChip(QObject *parent = nullptr);
+    ~SimulatedGpioChip();
+
+    bool watch(unsigned line) override;
+    bool value(unsigned line) const override;
+
+    // Sets an input level, an edge is queued if the level changed
+    void setValue(unsigned line, bool value);
+
+private:
+    void readEvents();
+
+    int m_pipe[2] = {-1, -1};
+    QSocketNotifier *m_notifier{nullptr};
+    QHash<unsigned, bool> m_values;
+    QSet<unsigned> m_watched;
+};
+
+#endif // SIMULATEDGPIOCHIP_H
@@ -0,0 +1,138 @@
+#include "slidingmedian.h"
+
+SlidingMedian::SlidingMedian(int window)
+{
+    window = qMax(1, window);
+    m_nodes.resize(window + 2);
+    m_free.reserve(window);
+    m_history.resize(window);
+    clear();
+}
+
+void SlidingMedian::clear()
+{
+    Node &head = m_nodes[HEAD];
+    head.levels = MAX_LEVELS;
+    for (int level = 0; level < MAX_LEVELS; ++level) {
+        head.next[level] = NIL;
+        head.width[level] = 1;
+    }
+    m_nodes[NIL].levels = 0;
+
+    m_free.clear();
+    for (int i = m_nodes.size() - 1; i > NIL; --i) {
+        m_free.append(i);
+    }
+    m_oldest = 0;
+    m_size = 0;
+}
+
+void SlidingMedian::push(int value)
+{
+    const int window = m_history.size();
+    if (m_size == window) {
+        remove(m_history[m_oldest]);
+        m_history[m_oldest] = value;
+        m_oldest = (m_oldest + 1) % window;
+    } else {
+        m_history[(m_oldest + m_size) % window] = value;
+    }
+    insert(value);
+}
+
+float SlidingMedian::median() const
+{
+    if (m_size == 0)
+        return 0.0f;
+    if (m_size % 2)
+        return at(m_size / 2);
+    return (at(m_size / 2 - 1) + at(m_size / 2)) / 2.0f;
+}
+
+int SlidingMedian::at(int index) const
+{
+    // Widths count from the head, which is position 0
+    int node = HEAD;
+    int remaining = index + 1;
+    for (int level = MAX_LEVELS - 1; level >= 0; --level) {
+        while (m_nodes[node].next[level] != NIL && m_nodes[node].width[level] <= remaining) {
+            remaining -= m_nodes[node].width[level];
+            node = m_nodes[node].next[level];
+        }
+    }
+    return m_nodes[node].value;
+}
+
+void SlidingMedian::insert(int value)
+{
+    // Rightmost node before value on every level and the position it is at
+    int chain[MAX_LEVELS];
+    int stepsAtLevel[MAX_LEVELS] = {};
+    int node = HEAD;
+    for (int level = MAX_LEVELS - 1; level >= 0; --level) {
+        int next = m_nodes[node].next[level];
+        while (next != NIL && m_nodes[next].value <= value) {
+            stepsAtLevel[level] += m_nodes[node].width[level];
+            node = next;
+            next = m_nodes[node].next[level];
+        }
+        chain[level] = node;
+    }
+
+    const int created = m_free.takeLast();
+    Node &fresh = m_nodes[created];
+    fresh.value = value;
+    fresh.levels = randomLevels();
+
+    int steps = 0;
+    for (int level = 0; level < fresh.levels; ++level) {
+        Node &previous = m_nodes[chain[level]];
+        fresh.next[level] = previous.next[level];
+        previous.next[level] = created;
+        fresh.width[level] = previous.width[level] - steps;
+        previous.width[level] = steps + 1;
+        steps += stepsAtLevel[level];
+    }
+    for (int level = fresh.levels; level < MAX_LEVELS; ++level) {
+        m_nodes[chain[level]].width[level]++;
+    }
+    m_size++;
+}
+
+void SlidingMedian::remove(int value)
+{
+    int chain[MAX_LEVELS];
+    int node = HEAD;
+    for (int level = MAX_LEVELS - 1; level >= 0; --level) {
+        int next = m_nodes[node].next[level];
+        while (next != NIL && m_nodes[next].value < value) {
+            node = next;
+            next = m_nodes[node].next[level];
+        }
+        chain[level] = node;
+    }
+
+    // Any node holding value will do, equal values are interchangeable
+    const int removed = m_nodes[chain[0]].next[0];
+    Q_ASSERT(removed != NIL && m_nodes[removed].value == value);
+    const Node &old = m_nodes[removed];
+    for (int level = 0; level < old.levels; ++level) {
+        Node &previous = m_nodes[chain[level]];
+        previous.width[level] += old.width[level] - 1;
+        previous.next[level] = old.next[level];
+    }
+    for (int level = old.levels; level < MAX_LEVELS; ++level) {
+        m_nodes[chain[level]].width[level]--;
+    }
+    m_free.append(removed);
+    m_size--;
+}
+
+int SlidingMedian::randomLevels()
+{
+    // xorshift32, each extra level with probability 1/2
+    m_random ^= m_random << 13;
+    m_random ^= m_random >> 17;
+    m_random ^= m_random << 5;
+    return qMin(MAX_LEVELS, 1 + __builtin_ctz(m_random | (1u << (MAX_LEVELS - 1))));
+}
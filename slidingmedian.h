@@ -0,0 +1,56 @@
+#ifndef SLIDINGMEDIAN_H
+#define SLIDINGMEDIAN_H
+
+#include <QtGlobal>
+#include <QVector>
+
+// Median of the last window values. The values are kept ordered in an
+// indexable skiplist (every link stores how many elements it skips), so a
+// push, the eviction of the oldest value and the lookup of the middle
+// element are O(log window). Nodes come from a pool sized at construction,
+// nothing is allocated per value.
+class SlidingMedian
+{
+public:
+    static constexpr int MAX_LEVELS = 8;      // Plenty for windows of a few hundred
+
+    explicit SlidingMedian(int window);
+
+    // Adds a value, evicting the oldest once the window is full
+    void push(int value);
+
+    // Median of the values in the window, the mean of the two middle ones
+    // for an even count, 0 when empty
+    float median() const;
+
+    // Value of rank index in ascending order, 0 <= index < size()
+    int at(int index) const;
+
+    int size() const { return m_size; }
+    int window() const { return m_history.size(); }
+    void clear();
+
+private:
+    struct Node {
+        int value;
+        int levels;
+        int next[MAX_LEVELS];
+        int width[MAX_LEVELS];        // Elements skipped by next, itself included
+    };
+
+    static constexpr int HEAD = 0;
+    static constexpr int NIL = 1;
+
+    void insert(int value);
+    void remove(int value);
+    int randomLevels();
+
+    QVector<Node> m_nodes;            // HEAD, NIL, then the pool
+    QVector<int> m_free;              // Unused pool nodes
+    QVector<int> m_history;           // Ring buffer of values in arrival order
+    int m_oldest = 0;
+    int m_size = 0;
+    quint32 m_random = 0x9e3779b9;
+};
+
+#endif // SLIDINGMEDIAN_H
@@ -0,0 +1,122 @@
+#include "startuptracker.h"
+#include "logger.h"
+#include "metrics.h"
+#include <QDebug>
+#include <QtGlobal>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <ctime>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+StartupTracker::StartupTracker(QObject *parent)
+    : QObject(parent)
+{
+    m_elapsed.start();
+    for (int i = 0; i < TaskCount; ++i) {
+        m_started[i] = -1;
+        m_finished[i] = -1;
+    }
+}
+
+void StartupTracker::begin(Task task)
+{
+    if (m_started[task] < 0)
+        m_started[task] = m_elapsed.elapsed();
+}
+
+void StartupTracker::finish(Task task, bool ok)
+{
+    if (m_finished[task] >= 0)
+        return;
+
+    begin(task);
+    m_finished[task] = m_elapsed.elapsed();
+    qDebug().noquote() << "Start-up task" << taskName(task) << (ok ? "done in" : "failed after")
+                       << m_finished[task] - m_started[task] << "ms";
+
+    if (!ok && !m_failed) {
+        // Final, the daemon stays up to tell clients but will not become ready
+        m_failed = true;
+        qCritical() << "Start-up failed, not reporting ready";
+        const QByteArray status = QByteArray("STATUS=Start-up failed: ") + taskName(task);
+        notifySystemd(status.constData());
+        emit failed(task);
+    }
+    if (m_failed)
+        return;
+
+    for (qint64 finished : m_finished) {
+        if (finished < 0)
+            return;
+    }
+
+    m_ready = true;
+    const qint64 readyMs = m_elapsed.elapsed();
+    Metrics::instance().startupReadyMs.store(readyMs, std::memory_order_relaxed);
+    LOG_INFO(logMeter, "Ready %.0f ms after start, %.0f ms after boot", readyMs, sinceBootMs());
+    notifySystemd("READY=1");
+    emit ready();
+}
+
+void StartupTracker::markFirstReading()
+{
+    if (m_firstReading)
+        return;
+
+    m_firstReading = true;
+    const qint64 fromStart = m_elapsed.elapsed();
+    const qint64 fromBoot = sinceBootMs();
+    Metrics &metrics = Metrics::instance();
+    metrics.startupFirstReadingMs.store(fromStart, std::memory_order_relaxed);
+    metrics.bootFirstReadingMs.store(fromBoot, std::memory_order_relaxed);
+    LOG_INFO(logMeter, "First reading %.0f ms after start, %.0f ms after boot", fromStart, fromBoot);
+}
+
+const char *StartupTracker::taskName(Task task)
+{
+    switch (task) {
+    case Ble:
+        return "ble";
+    case Hardware:
+        return "hardware";
+    case StateRestore:
+        return "state_restore";
+    case Calibration:
+        return "calibration";
+    default:
+        return "unknown";
+    }
+}
+
+qint64 StartupTracker::sinceBootMs()
+{
+    timespec now;
+    if (clock_gettime(CLOCK_BOOTTIME, &now) != 0)
+        return -1;
+    return static_cast<qint64>(now.tv_sec) * 1000 + now.tv_nsec / 1000000;
+}
+
+void StartupTracker::notifySystemd(const char *state)
+{
+    const QByteArray path = qgetenv("NOTIFY_SOCKET");
+    if (path.isEmpty() || path.size() >= static_cast<int>(sizeof(sockaddr_un::sun_path)))
+        return;
+
+    sockaddr_un address;
+    memset(&address, 0, sizeof(address));
+    address.sun_family = AF_UNIX;
+    memcpy(address.sun_path, path.constData(), path.size());
+    if (address.sun_path[0] == '@')
+        address.sun_path[0] = '\0';     // Abstract namespace
+
+    int fd = socket(AF_UNIX, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd < 0)
+        return;
+    const socklen_t length = offsetof(sockaddr_un, sun_path) + path.size();
+    if (sendto(fd, state, strlen(state), 0, reinterpret_cast<sockaddr*>(&address), length) < 0)
+        qWarning() << "Can not notify systemd:" << strerror(errno);
+    close(fd);
+}
@@ -0,0 +1,54 @@
+#ifndef STARTUPTRACKER_H
+#define STARTUPTRACKER_H
+
+#include <QObject>
+#include <QElapsedTimer>
+
+// Follows the independent start-up tasks of the daemon. They run
+// concurrently, and ready() is emitted once all of them have finished. A
+// failed task means the daemon never reports ready; the first failure is
+// reported to systemd and through failed() right away. Tasks are finished from
+// the event loop, so every task that is begun before it starts is waited for.
+//
+// Times are reported from the tracker's creation and from kernel boot
+// (CLOCK_BOOTTIME), which includes the firmware, kernel and systemd part
+// of a power cycle.
+class StartupTracker : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum Task { Ble = 0, Hardware, StateRestore, Calibration, TaskCount };
+
+    explicit StartupTracker(QObject *parent = nullptr);
+
+    void begin(Task task);
+    void finish(Task task, bool ok = true);
+
+    bool isFinished(Task task) const { return m_finished[task] >= 0; }
+    bool isReady() const { return m_ready; }
+    bool hasFailed() const { return m_failed; }
+
+    // First reading after start-up, only the first call counts
+    void markFirstReading();
+
+    static const char *taskName(Task task);
+    static qint64 sinceBootMs();
+
+signals:
+    void ready();
+    void failed(StartupTracker::Task task);
+
+private:
+    // sd_notify without libsystemd, for Type=notify units
+    static void notifySystemd(const char *state);
+
+    QElapsedTimer m_elapsed;
+    qint64 m_started[TaskCount];
+    qint64 m_finished[TaskCount];
+    bool m_ready = false;
+    bool m_failed = false;
+    bool m_firstReading = false;
+};
+
+#endif // STARTUPTRACKER_H
@@ -0,0 +1,185 @@
+#include "telemetryserver.h"
+#include "message.h"
+#include "metrics.h"
+#include <QDebug>
+
+TelemetryServer::TelemetryServer(quint16 port, const QHostAddress &address, QObject *parent)
+    : Transport(parent)
+    , m_port(port)
+    , m_address(address)
+{
+    tcpServer = new QTcpServer(this);
+    connect(tcpServer, &QTcpServer::newConnection, this, &TelemetryServer::onNewConnection);
+}
+
+TelemetryServer::~TelemetryServer()
+{
+    stop();
+}
+
+void TelemetryServer::start()
+{
+    listen(m_port);
+}
+
+bool TelemetryServer::listen(quint16 port)
+{
+    if (tcpServer->isListening())
+        return true;
+
+    if (!tcpServer->listen(m_address, port)) {
+        auto statusText = QString("Telemetry server can not listen on %1 port %2: %3")
+                              .arg(m_address.toString()).arg(port).arg(tcpServer->errorString());
+        emit sendInfo(statusText);
+        qWarning() << statusText;
+        return false;
+    }
+
+    auto statusText = QString("Listening for telemetry subscribers on %1 port %2")
+                          .arg(m_address.toString()).arg(tcpServer->serverPort());
+    emit sendInfo(statusText);
+    qDebug() << statusText;
+    if (!m_address.isLoopback())
+        qWarning() << "Telemetry endpoint is reachable from the network without authentication";
+    return true;
+}
+
+void TelemetryServer::stop()
+{
+    if (tcpServer->isListening())
+        tcpServer->close();
+
+    const auto sockets = subscribers.keys();
+    for (QTcpSocket *socket : sockets) {
+        socket->disconnect(this);
+        socket->abort();
+        socket->deleteLater();
+    }
+
+    if (!subscribers.isEmpty()) {
+        subscribers.clear();
+        emit connectionState(false);
+    }
+}
+
+void TelemetryServer::writeValue(const QByteArray &value)
+{
+    for (auto it = subscribers.cbegin(); it != subscribers.cend(); ++it) {
+        write(it.key(), value);
+    }
+}
+
+void TelemetryServer::writeTo(quint32 peer, const QByteArray &value)
+{
+    if (peer == 0) {
+        writeValue(value);
+        return;
+    }
+    for (auto it = subscribers.cbegin(); it != subscribers.cend(); ++it) {
+        if (it.value().peer == peer) {
+            write(it.key(), value);
+            return;
+        }
+    }
+}
+
+void TelemetryServer::write(QTcpSocket *socket, const QByteArray &value)
+{
+    // A stalled subscriber must not grow our memory or delay the others
+    if (socket->bytesToWrite() > MAX_PENDING_BYTES) {
+        m_droppedFrames++;
+        Metrics::instance().framesDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    socket->write(value);
+    Metrics::instance().framesSent.fetch_add(1, std::memory_order_relaxed);
+    Metrics::instance().bytesSent.fetch_add(value.size(), std::memory_order_relaxed);
+}
+
+bool TelemetryServer::isConnected() const
+{
+    return !subscribers.isEmpty();
+}
+
+int TelemetryServer::subscriberCount() const
+{
+    return subscribers.size();
+}
+
+quint32 TelemetryServer::currentPeer() const
+{
+    return m_currentPeer;
+}
+
+quint64 TelemetryServer::droppedFrames() const
+{
+    return m_droppedFrames;
+}
+
+void TelemetryServer::onNewConnection()
+{
+    while (QTcpSocket *socket = tcpServer->nextPendingConnection()) {
+        socket->setSocketOption(QAbstractSocket::LowDelayOption, 1);
+        connect(socket, &QTcpSocket::readyRead, this, &TelemetryServer::onReadyRead);
+        connect(socket, &QTcpSocket::disconnected, this, &TelemetryServer::onDisconnected);
+
+        bool first = subscribers.isEmpty();
+        Subscriber subscriber;
+        subscriber.peer = m_nextPeer++;
+        subscribers.insert(socket, subscriber);
+
+        auto statusText = QString("Telemetry subscriber connected %1:%2").arg(socket->peerAddress().toString()).arg(socket->peerPort());
+        emit sendInfo(statusText);
+        qDebug() << statusText;
+
+        if (first)
+            emit connectionState(true);
+    }
+}
+
+void TelemetryServer::onReadyRead()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket || !subscribers.contains(socket))
+        return;
+
+    subscribers[socket].rxBuffer.append(socket->readAll());
+
+    // Looked up again for every frame, a handler may change the subscribers
+    for (auto it = subscribers.find(socket); it != subscribers.end(); it = subscribers.find(socket)) {
+        QByteArray &buffer = it->rxBuffer;
+        int size = Message::frameSize(buffer);
+        if (size == 0)
+            break;
+
+        if (size < 0) {
+            // Resynchronise on the next header byte
+            int next = buffer.indexOf(static_cast<char>(mHeader), 1);
+            buffer.remove(0, next < 0 ? buffer.size() : next);
+            continue;
+        }
+
+        QByteArray frame = buffer.left(size);
+        buffer.remove(0, size);
+        m_currentPeer = it->peer;
+        emit dataReceived(frame);
+        m_currentPeer = 0;
+    }
+}
+
+void TelemetryServer::onDisconnected()
+{
+    QTcpSocket *socket = qobject_cast<QTcpSocket*>(sender());
+    if (!socket)
+        return;
+
+    subscribers.remove(socket);
+    socket->deleteLater();
+
+    auto statusText = QString("Telemetry subscriber disconnected %1").arg(socket->peerAddress().toString());
+    emit sendInfo(statusText);
+    qDebug() << statusText;
+
+    if (subscribers.isEmpty())
+        emit connectionState(false);
+}
@@ -0,0 +1,62 @@
+#ifndef TELEMETRYSERVER_H
+#define TELEMETRYSERVER_H
+
+#include <QHash>
+#include <QByteArray>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include "transport.h"
+
+// Local TCP endpoint publishing the same framed message.h stream as the
+// GATT characteristic. Every subscriber receives every frame, and frames
+// written by any subscriber are handed to the same command handler as BLE.
+// Replies to one subscriber go through writeTo() with its peer number.
+// Subscribers are not authenticated and may start, calibrate and retune the
+// meter, so the server only listens on loopback unless told otherwise.
+class TelemetryServer : public Transport
+{
+    Q_OBJECT
+
+public:
+    static constexpr quint16 DEFAULT_PORT = 5050;
+    static constexpr qint64 MAX_PENDING_BYTES = 256 * 1024;  // Per subscriber backlog before frames are dropped
+
+    explicit TelemetryServer(quint16 port = DEFAULT_PORT, const QHostAddress &address = QHostAddress::LocalHost,
+                             QObject *parent = nullptr);
+    ~TelemetryServer();
+
+    void start() override;
+    void stop() override;
+    void writeValue(const QByteArray &value) override;
+    bool isConnected() const override;
+    quint32 currentPeer() const override;
+    void writeTo(quint32 peer, const QByteArray &value) override;
+
+    bool listen(quint16 port);
+    int subscriberCount() const;
+    quint64 droppedFrames() const;
+
+private slots:
+    void onNewConnection();
+    void onReadyRead();
+    void onDisconnected();
+
+private:
+    struct Subscriber {
+        quint32 peer = 0;                   // Never reused, a late reply can not reach a newcomer
+        QByteArray rxBuffer;
+    };
+
+    void write(QTcpSocket *socket, const QByteArray &value);
+
+    QTcpServer *tcpServer{nullptr};
+    quint16 m_port;
+    QHostAddress m_address;
+    QHash<QTcpSocket*, Subscriber> subscribers;
+    quint32 m_nextPeer = 1;
+    quint32 m_currentPeer = 0;
+    quint64 m_droppedFrames = 0;
+};
+
+#endif // TELEMETRYSERVER_H
@@ -0,0 +1,14 @@
+#include "wiringpiadcsource.h"
+
+#include <wiringPi.h>
+#include <ads1115.h>
+
+bool WiringPiAdcSource::open()
+{
+    return ads1115Setup(PIN_BASE, ADS_ADDR) != 0;
+}
+
+int WiringPiAdcSource::read(int channel)
+{
+    return analogRead(PIN_BASE + channel);
+}
@@ -0,0 +1,18 @@
+#ifndef WIRINGPIADCSOURCE_H
+#define WIRINGPIADCSOURCE_H
+
+#include "adcsource.h"
+
+// ADS1115 on i2c through the wiringPi ads1115 extension. wiringPi itself
+// must already be set up by the caller.
+class WiringPiAdcSource : public AdcSource
+{
+public:
+    static constexpr int PIN_BASE = 120;
+    static constexpr int ADS_ADDR = 0x48;
+
+    bool open() override;
+    int read(int channel) override;
+};
+
+#endif // WIRINGPIADCSOURCE_H